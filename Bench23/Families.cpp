@@ -0,0 +1,141 @@
+#include "Families.h"
+
+#include <sstream>
+#include <string>
+
+using std::vector;
+
+inline namespace helpers {
+    using Row = vector<long>;
+    
+    // zero coefficients are left out of the written polynom
+    std::string
+    polynom(Row const& coeffs) {
+        std::ostringstream os;
+        bool first = true;
+        for(auto j = 0u; j < coeffs.size(); ++j) {
+            if(coeffs[j] == 0) continue;
+            
+            if(!first) os << (coeffs[j] < 0 ? " - " : " + ");
+            else if(coeffs[j] < 0) os << "-";
+            os << std::labs(coeffs[j]) << "x" << j + 1;
+            first = false;
+        }
+        return os.str();
+    }
+    
+    Solver
+    make_solver(Row const& goal, char const* dir, vector<Row> const& rows, Row const& rights) {
+        Solver s;
+        s.set_goal(polynom(goal) + " => " + dir);
+        for(auto i = 0u; i < rows.size(); ++i) {
+            s.add_restriction(polynom(rows[i]) + " <= " + std::to_string(rights[i]));
+        }
+        return s;
+    }
+    
+    Row
+    random_row(std::mt19937& gen, int size, long lo, long hi) {
+        std::uniform_int_distribution<long> coeff {lo, hi};
+        
+        Row ret (size);
+        for(auto& c : ret) {
+            c = coeff(gen);
+        }
+        return ret;
+    }
+    
+    // positive <= rows with a positive right side: x = 0 is feasible
+    Solver
+    random_dense(std::mt19937& gen, int size) {
+        vector<Row> rows;
+        Row rights;
+        for(int i = 0; i < size; ++i) {
+            rows.push_back(random_row(gen, size, 1, 9));
+            rights.push_back(random_row(gen, 1, 10, 99).front());
+        }
+        return make_solver(random_row(gen, size, 1, 9), "max", rows, rights);
+    }
+    
+    // about a fifth of the cells set, every column kept bounded
+    Solver
+    random_sparse(std::mt19937& gen, int size) {
+        std::bernoulli_distribution set {0.2};
+        std::uniform_int_distribution<int> pick {0, size - 1};
+        
+        vector<Row> rows (size, Row(size, 0));
+        Row rights;
+        for(int i = 0; i < size; ++i) {
+            auto coeffs = random_row(gen, size, 1, 9);
+            for(int j = 0; j < size; ++j) {
+                if(set(gen)) rows[i][j] = coeffs[j];
+            }
+            rights.push_back(random_row(gen, 1, 10, 99).front());
+        }
+        for(int j = 0; j < size; ++j) {
+            rows[pick(gen)][j] = random_row(gen, 1, 1, 9).front();
+        }
+        return make_solver(random_row(gen, size, 1, 9), "max", rows, rights);
+    }
+    
+    // dantzig's rule visits all 2^n vertices of the deformed cube
+    Solver
+    klee_minty(std::mt19937&, int size) {
+        Row goal (size);
+        vector<Row> rows (size, Row(size, 0));
+        Row rights (size);
+        
+        long five = 1;
+        for(int i = 0; i < size; ++i) {
+            goal[i] = 1l << (size - 1 - i);
+            
+            for(int j = 0; j < i; ++j) {
+                rows[i][j] = 1l << (i - j + 1);
+            }
+            rows[i][i] = 1;
+            
+            five *= 5;
+            rights[i] = five;
+        }
+        return make_solver(goal, "max", rows, rights);
+    }
+    
+    // most rows pass through the origin, so many pivots keep w
+    Solver
+    degenerate(std::mt19937& gen, int size) {
+        vector<Row> rows;
+        Row rights;
+        for(int i = 0; i < size - 1; ++i) {
+            rows.push_back(random_row(gen, size, -5, 5));
+            rights.push_back(0);
+        }
+        rows.push_back(Row(size, 1));
+        rights.push_back(10 * size);
+        return make_solver(random_row(gen, size, 1, 9), "max", rows, rights);
+    }
+    
+    // wide coefficients with a >= row make the tableau fractions grow fast
+    Solver
+    coefficient_growth(std::mt19937& gen, int size) {
+        vector<Row> rows;
+        Row rights;
+        for(int i = 0; i < size; ++i) {
+            rows.push_back(random_row(gen, size, 101, 997));
+            rights.push_back(random_row(gen, 1, 1000, 9999).front());
+        }
+        
+        auto s = make_solver(random_row(gen, size, 101, 997), "max", rows, rights);
+        s.add_restriction(polynom(random_row(gen, size, 1, 9)) + " >= 1");
+        return s;
+    }
+}
+
+vector<Family> lp_families() {
+    return {
+        {"random_dense",       {4, 8, 16, 24, 32},  random_dense},
+        {"random_sparse",      {8, 16, 24, 32, 48}, random_sparse},
+        {"klee_minty",         {3, 5, 7, 9, 11},    klee_minty},
+        {"degenerate",         {4, 8, 12, 16},      degenerate},
+        {"coefficient_growth", {2, 4, 6, 8},        coefficient_growth},
+    };
+}
@@ -0,0 +1,17 @@
+#ifndef FAMILIES_H_INCLUDED
+#define FAMILIES_H_INCLUDED
+
+#include <Solver.h>
+#include <random>
+#include <vector>
+
+// a seeded generator of models that grow with size
+struct Family {
+    char const*      name;
+    std::vector<int> sizes;
+    Solver (*make)(std::mt19937& gen, int size);
+};
+
+std::vector<Family> lp_families();
+
+#endif
@@ -0,0 +1,242 @@
+#include <BatchSolver.h>
+#include "Families.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <sys/resource.h>
+
+using std::vector;
+
+inline namespace helpers {
+    std::string
+    random_polynom(std::mt19937& gen, int varsNum) {
+        std::uniform_int_distribution<int> coeff {1, 9};
+        
+        std::ostringstream os;
+        for(int j = 1; j <= varsNum; ++j) {
+            if(j > 1) os << " + ";
+            os << coeff(gen) << "x" << j;
+        }
+        return os.str();
+    }
+    
+    // positive rows with a positive right side, so x = 0 is feasible
+    // and every variable is bounded
+    BatchSolver::Model
+    random_model(std::mt19937& gen) {
+        std::uniform_int_distribution<int> size {2, 6};
+        std::uniform_int_distribution<int> right {10, 99};
+        
+        int varsNum = size(gen);
+        int restrsNum = size(gen);
+        
+        BatchSolver::Model m;
+        m.goal = random_polynom(gen, varsNum) + " => max";
+        for(int i = 0; i < restrsNum; ++i) {
+            std::ostringstream os;
+            os << random_polynom(gen, varsNum) << " <= " << right(gen);
+            m.restrs.push_back(os.str());
+        }
+        return m;
+    }
+    
+    // high-water mark of the whole process, it never goes down
+    long
+    peak_rss_kb() {
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+    }
+    
+    char const*
+    status_name(Solver::Status s) {
+        switch(s) {
+            case Solver::Status::optimal:    return "optimal";
+            case Solver::Status::infeasible: return "infeasible";
+            case Solver::Status::unbounded:  return "unbounded";
+            case Solver::Status::cycled:     return "cycled";
+            case Solver::Status::limit:      return "limit";
+            case Solver::Status::cancelled:  return "cancelled";
+            case Solver::Status::overflow:   return "overflow";
+            default:                         return "none";
+        }
+    }
+    
+    struct FamilyResult {
+        char const* family;
+        int         size;
+        unsigned    samples = 0;
+        double      seconds = 0;    // failed samples are left out of
+        double      iterations = 0; // these and the mean pivots per sample
+        unsigned    maxNumBits = 0;
+        unsigned    maxDenBits = 0;
+        long        peakRssKb = 0;
+        unsigned    failed = 0;     // Fraction overflowed its int_t
+        std::vector<Solver::Status> statuses;
+    };
+    
+    FamilyResult
+    run_family(Family const& f, int size, unsigned samples, unsigned seed) {
+        FamilyResult r;
+        r.family = f.name;
+        r.size = size;
+        r.samples = samples;
+        
+        std::mt19937 gen {seed + static_cast<unsigned>(size)};
+        for(auto i = 0u; i < samples; ++i) {
+            auto solver = f.make(gen, size);
+            
+            Solver::Stats stats;
+            Solver::Options options;
+            options.stats = &stats;
+            options.deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+            
+            auto start = std::chrono::steady_clock::now();
+            try {
+                auto steps = solver.solve(options);
+                r.statuses.push_back(steps.back().status);
+            }
+            catch(std::overflow_error const&) {
+                ++r.failed;
+                continue;
+            }
+            std::chrono::duration<double> took = std::chrono::steady_clock::now() - start;
+            
+            r.seconds += took.count();
+            r.iterations += stats.iterations.empty() ? 0 : stats.iterations.size() - 1;
+            r.maxNumBits = std::max(r.maxNumBits, stats.maxNumBits);
+            r.maxDenBits = std::max(r.maxDenBits, stats.maxDenBits);
+        }
+        if(r.failed < samples) r.iterations /= samples - r.failed;
+        r.peakRssKb = peak_rss_kb();
+        
+        return r;
+    }
+    
+    void
+    write_json(std::ostream& os, vector<FamilyResult> const& results, unsigned seed) {
+        os << "{\"seed\":" << seed << ",\"results\":[";
+        
+        auto sep = "";
+        for(auto const& r : results) {
+            os << sep << "\n{\"family\":\"" << r.family << "\""
+               << ",\"size\":" << r.size
+               << ",\"samples\":" << r.samples
+               << ",\"seconds\":" << r.seconds
+               << ",\"mean_iterations\":" << r.iterations
+               << ",\"max_num_bits\":" << r.maxNumBits
+               << ",\"max_den_bits\":" << r.maxDenBits
+               << ",\"peak_rss_kb\":" << r.peakRssKb
+               << ",\"failed\":" << r.failed
+               << ",\"statuses\":[";
+            
+            auto ssep = "";
+            for(auto st : r.statuses) {
+                os << ssep << "\"" << status_name(st) << "\"";
+                ssep = ",";
+            }
+            os << "]}";
+            sep = ",";
+        }
+        os << "\n]}\n";
+    }
+    
+    // Bench23 families [seed] [samples] [out.json]
+    int
+    run_families(int argc, char* argv[]) {
+        unsigned seed = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 42;
+        unsigned samples = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 5;
+        char const* outPath = argc > 4 ? argv[4] : "bench23.json";
+        samples = std::max(1u, samples);
+        
+        std::cout << "seed: " << seed << ", samples: " << samples << '\n';
+        std::cout << std::left << std::setw(20) << "family" << std::right
+                  << std::setw(6) << "size" << std::setw(12) << "ms/model"
+                  << std::setw(8) << "pivots" << std::setw(6) << "bits"
+                  << std::setw(10) << "rss KB" << std::setw(8) << "failed" << '\n';
+        
+        vector<FamilyResult> results;
+        for(auto const& f : lp_families()) {
+            for(int size : f.sizes) {
+                results.push_back(run_family(f, size, samples, seed));
+                auto const& r = results.back();
+                
+                std::cout << std::left << std::setw(20) << r.family << std::right
+                          << std::setw(6) << r.size
+                          << std::setw(12) << std::fixed << std::setprecision(3) 
+                          << r.seconds * 1000 / std::max(1u, r.samples - r.failed)
+                          << std::setw(8) << std::setprecision(1) << r.iterations
+                          << std::setw(6) << std::max(r.maxNumBits, r.maxDenBits)
+                          << std::setw(10) << r.peakRssKb
+                          << std::setw(8) << r.failed << '\n';
+            }
+        }
+        
+        std::ofstream out {outPath};
+        write_json(out, results, seed);
+        std::cout << "results written to " << outPath << '\n';
+        
+        return out ? 0 : 1;
+    }
+    
+    // Bench23 [models] [seed] [threads]
+    int
+    run_batch(int argc, char* argv[]) {
+        std::size_t modelsNum = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+        unsigned seed = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 42;
+        unsigned maxThreads = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 0;
+        if(maxThreads == 0) {
+            maxThreads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        
+        // powers of two, then the full count
+        vector<unsigned> threadCounts;
+        for(unsigned threads = 1; threads < maxThreads; threads *= 2) {
+            threadCounts.push_back(threads);
+        }
+        threadCounts.push_back(maxThreads);
+        
+        std::mt19937 gen {seed};
+        vector<BatchSolver::Model> models;
+        for(auto i = 0u; i < modelsNum; ++i) {
+            models.push_back(random_model(gen));
+        }
+        
+        std::cout << "models: " << modelsNum << ", seed: " << seed << '\n';
+        std::cout << std::setw(8) << "threads" << std::setw(14) << "models/s" << std::setw(10) << "speedup" << '\n';
+        
+        double base = 0;
+        for(unsigned threads : threadCounts) {
+            BatchSolver batch {threads};
+            
+            auto start = std::chrono::steady_clock::now();
+            auto lasts = batch.solve(models);
+            std::chrono::duration<double> took = std::chrono::steady_clock::now() - start;
+            
+            double rate = modelsNum / took.count();
+            if(threads == 1) base = rate;
+            
+            std::cout << std::setw(8) << threads
+                      << std::setw(14) << std::fixed << std::setprecision(0) << rate
+                      << std::setw(10) << std::setprecision(2) << rate / base << '\n';
+        }
+        
+        return 0;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if(argc > 1 && std::strcmp(argv[1], "families") == 0) {
+        return run_families(argc, argv);
+    }
+    return run_batch(argc, argv);
+}
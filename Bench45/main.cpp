@@ -0,0 +1,380 @@
+#include <Auction.h>
+#include <BalanceMatrix.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+
+using std::vector;
+using Matrix = vector<vector<int>>;
+
+inline namespace helpers {
+    using Clock = std::chrono::steady_clock;
+    
+    // high-water mark of the whole process, it never goes down
+    long
+    peak_rss_kb() {
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+    }
+    
+    vector<int>
+    random_line(std::mt19937& gen, int size, int lo, int hi) {
+        std::uniform_int_distribution<int> value {lo, hi};
+        
+        vector<int> ret (size);
+        for(auto& v : ret) {
+            v = value(gen);
+        }
+        return ret;
+    }
+    
+    // scales the line so its sum is close to total, the last cell takes the rest
+    void
+    rescale(vector<int>& line, int total) {
+        auto sum = std::accumulate(line.begin(), line.end(), 0ll);
+        long long used = 0;
+        for(auto i = 0u; i + 1 < line.size(); ++i) {
+            line[i] = std::max(1ll, line[i] * total / sum);
+            used += line[i];
+        }
+        line.back() = static_cast<int>(std::max(1ll, total - used));
+    }
+    
+    // rows of costs with the supply last, then the demands row
+    Matrix
+    compose(Matrix costs, vector<int> const& prods, vector<int> const& consums) {
+        for(auto i = 0u; i < costs.size(); ++i) {
+            costs[i].push_back(prods[i]);
+        }
+        costs.push_back(consums);
+        return costs;
+    }
+    
+    Matrix
+    uniform_costs(std::mt19937& gen, int prodsNum, int consumsNum) {
+        Matrix ret;
+        for(int i = 0; i < prodsNum; ++i) {
+            ret.push_back(random_line(gen, consumsNum, 1, 99));
+        }
+        return ret;
+    }
+    
+    // sources and sinks gathered around a few sites, cost is the distance
+    Matrix
+    clustered_costs(std::mt19937& gen, int prodsNum, int consumsNum) {
+        std::uniform_real_distribution<double> site {0, 1000};
+        std::normal_distribution<double> spread {0, 40};
+        
+        vector<std::pair<double, double>> sites (5);
+        for(auto& s : sites) {
+            s = {site(gen), site(gen)};
+        }
+        
+        std::uniform_int_distribution<int> pick {0, static_cast<int>(sites.size()) - 1};
+        auto place = [&]() {
+            auto s = sites[pick(gen)];
+            return std::make_pair(s.first + spread(gen), s.second + spread(gen));
+        };
+        
+        vector<std::pair<double, double>> prods (prodsNum), consums (consumsNum);
+        std::generate(prods.begin(), prods.end(), place);
+        std::generate(consums.begin(), consums.end(), place);
+        
+        Matrix ret (prodsNum, vector<int>(consumsNum));
+        for(int i = 0; i < prodsNum; ++i) {
+            for(int j = 0; j < consumsNum; ++j) {
+                auto dx = prods[i].first - consums[j].first;
+                auto dy = prods[i].second - consums[j].second;
+                ret[i][j] = 1 + static_cast<int>(std::hypot(dx, dy));
+            }
+        }
+        return ret;
+    }
+    
+    struct Instance {
+        char const* name;
+        Matrix (*make)(std::mt19937& gen, int size);
+        bool assignment; // square with every quantity 1
+    };
+    
+    Matrix
+    uniform_balanced(std::mt19937& gen, int size) {
+        auto prods = random_line(gen, size, 10, 99);
+        auto consums = random_line(gen, size, 10, 99);
+        rescale(consums, std::accumulate(prods.begin(), prods.end(), 0));
+        return compose(uniform_costs(gen, size, size), prods, consums);
+    }
+    
+    // demand outweighs supply, so flatten adds a dummy source
+    Matrix
+    uniform_unbalanced(std::mt19937& gen, int size) {
+        auto prods = random_line(gen, size, 10, 99);
+        auto consums = random_line(gen, size, 10, 99);
+        rescale(consums, std::accumulate(prods.begin(), prods.end(), 0) * 6 / 5);
+        return compose(uniform_costs(gen, size, size), prods, consums);
+    }
+    
+    Matrix
+    clustered(std::mt19937& gen, int size) {
+        auto prods = random_line(gen, size, 10, 99);
+        auto consums = random_line(gen, size, 10, 99);
+        rescale(consums, std::accumulate(prods.begin(), prods.end(), 0));
+        return compose(clustered_costs(gen, size, size), prods, consums);
+    }
+    
+    // equal supplies and demands, every allocation closes a row and a column
+    Matrix
+    degenerate(std::mt19937& gen, int size) {
+        vector<int> line (size, 10);
+        return compose(uniform_costs(gen, size, size), line, line);
+    }
+    
+    // every quantity 1, the potential method is at its most degenerate
+    Matrix
+    assignment(std::mt19937& gen, int size) {
+        vector<int> line (size, 1);
+        return compose(uniform_costs(gen, size, size), line, line);
+    }
+    
+    struct Timing {
+        double seconds = 0;
+        long   iterations = -1; // -1 for initial plans, the network simplex and the Hungarian method
+        long   historyKb = 0;   // what the returned steps hold
+        bool   skipped = false;
+    };
+    
+    template <typename F>
+    double
+    seconds_of(F&& f) {
+        auto start = Clock::now();
+        f();
+        return std::chrono::duration<double> {Clock::now() - start}.count();
+    }
+    
+    // only the last step is kept, the rest are counted as they go by
+    Timing
+    time_solve(BalanceMatrix const& m, BalanceMatrix::Meth meth, BalanceMatrix::Options options) {
+        Timing t;
+        long stepsNum = 0;
+        options.record = BalanceMatrix::Record::last;
+        options.onStep = [&stepsNum](BalanceMatrix::Step const&) { ++stepsNum; };
+        
+        vector<BalanceMatrix::Step> steps;
+        t.seconds = seconds_of([&]() { steps = m.solve(meth, options); });
+        // the network simplex and the Hungarian method give only the last step
+        auto single = meth == BalanceMatrix::Meth::Network || meth == BalanceMatrix::Meth::Assignment;
+        t.iterations = single ? -1 : stepsNum - 1;
+        
+        std::size_t cells = 0;
+        for(auto const& s : steps) {
+            cells += s.X.rows() * s.X.cols() + s.D.rows() * s.D.cols();
+        }
+        t.historyKb = static_cast<long>(cells * sizeof(int) / 1024);
+        return t;
+    }
+    
+    char const* const methods[] = {
+        "key0_nw", "key0_min", "key0_vogel", 
+        "solve_nw", "solve_min", "solve_vogel", "solve_vogel_cand", "solve_network",
+        "solve_assignment", "solve_auction"
+    };
+    int const methodsNum = sizeof(methods) / sizeof(*methods);
+    
+    // the solving methods come last in methods
+    struct SolveMeth {
+        BalanceMatrix::Meth    meth;
+        BalanceMatrix::Pricing pricing;
+    };
+    SolveMeth const solveMeths[] = {
+        {BalanceMatrix::Meth::NW,         BalanceMatrix::Pricing::full},
+        {BalanceMatrix::Meth::Min,        BalanceMatrix::Pricing::full},
+        {BalanceMatrix::Meth::Vogel,      BalanceMatrix::Pricing::full},
+        {BalanceMatrix::Meth::Vogel,      BalanceMatrix::Pricing::candidates},
+        {BalanceMatrix::Meth::Network,    BalanceMatrix::Pricing::full},
+        {BalanceMatrix::Meth::Assignment, BalanceMatrix::Pricing::full},
+        {BalanceMatrix::Meth::Auction,    BalanceMatrix::Pricing::full},
+    };
+    int const solveMethsNum = sizeof(solveMeths) / sizeof(*solveMeths);
+    
+    struct Result {
+        char const* instance;
+        int         size;
+        Timing      timings[methodsNum];
+        long        peakRssKb = 0;
+    };
+    
+    // the auction alone, without the steps of the potential method after it
+    struct Scaling {
+        unsigned      threadsNum;
+        double        seconds;
+        unsigned long rounds;
+    };
+    
+    Scaling
+    time_auction(Matrix const& rows, unsigned threadsNum) {
+        auto const& consums = rows.back();
+        Matrix2D<long long> costs (rows.size() - 1, consums.size());
+        vector<long long> prods (costs.rows());
+        for(auto i = 0u; i < costs.rows(); ++i) {
+            std::copy(rows[i].begin(), rows[i].end() - 1, costs[i].begin());
+            prods[i] = rows[i].back();
+        }
+        
+        Auction auction {threadsNum};
+        Scaling ret {auction.threads_num(), 0, 0};
+        ret.seconds = seconds_of([&]() {
+            auction.solve(costs, prods, vector<long long> (consums.begin(), consums.end()));
+        });
+        ret.rounds = auction.rounds();
+        return ret;
+    }
+    
+    void
+    write_json(std::ostream& os, vector<Result> const& results, vector<Scaling> const& scaling, unsigned seed) {
+        os << "{\"seed\":" << seed << ",\"results\":[";
+        
+        auto sep = "";
+        for(auto const& r : results) {
+            os << sep << "\n{\"instance\":\"" << r.instance << "\""
+               << ",\"size\":" << r.size
+               << ",\"peak_rss_kb\":" << r.peakRssKb;
+            for(int k = 0; k < methodsNum; ++k) {
+                auto const& t = r.timings[k];
+                os << ",\"" << methods[k] << "\":";
+                if(t.skipped) {
+                    os << "null";
+                    continue;
+                }
+                os << "{\"seconds\":" << t.seconds;
+                if(t.iterations >= 0) {
+                    os << ",\"iterations\":" << t.iterations
+                       << ",\"history_kb\":" << t.historyKb;
+                }
+                os << "}";
+            }
+            os << "}";
+            sep = ",";
+        }
+        os << "\n],\"auction_scaling\":[";
+        
+        sep = "";
+        for(auto const& s : scaling) {
+            os << sep << "\n{\"threads\":" << s.threadsNum
+               << ",\"seconds\":" << s.seconds
+               << ",\"rounds\":" << s.rounds << "}";
+            sep = ",";
+        }
+        os << "\n]}\n";
+    }
+}
+
+// Bench45 [maxSize] [seed] [out.json] [solve budget, s]
+int main(int argc, char* argv[]) {
+    int maxSize = argc > 1 ? std::atoi(argv[1]) : 200;
+    unsigned seed = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 42;
+    char const* outPath = argc > 3 ? argv[3] : "bench45.json";
+    double budget = argc > 4 ? std::atof(argv[4]) : 60;
+    
+    vector<int> sizes;
+    for(int size : {10, 20, 50, 100, 200, 500, 1000}) {
+        if(size <= maxSize) sizes.push_back(size);
+    }
+    
+    Instance const instances[] = {
+        {"uniform_balanced",   uniform_balanced,   false},
+        {"uniform_unbalanced", uniform_unbalanced, false},
+        {"clustered",          clustered,          false},
+        {"degenerate",         degenerate,         false},
+        {"assignment",         assignment,         true},
+    };
+    
+    std::cout << "seed: " << seed << ", solve budget: " << budget << " s\n";
+    std::cout << std::left << std::setw(20) << "instance" << std::right << std::setw(6) << "size";
+    for(auto name : methods) {
+        std::cout << std::setw(17) << name;
+    }
+    std::cout << std::setw(8) << "pivots" << std::setw(10) << "rss KB" << '\n';
+    
+    vector<Result> results;
+    for(auto const& inst : instances) {
+        // a method that went over the budget isn't run on bigger sizes
+        bool over[solveMethsNum] = {};
+        
+        for(int size : sizes) {
+            std::mt19937 gen {seed + static_cast<unsigned>(size)};
+            BalanceMatrix m;
+            m.set(inst.make(gen, size));
+            
+            Result r;
+            r.instance = inst.name;
+            r.size = size;
+            r.timings[0].seconds = seconds_of([&]() { m.get_key0_by_nw_method(); });
+            r.timings[1].seconds = seconds_of([&]() { m.get_key0_by_min_method(); });
+            r.timings[2].seconds = seconds_of([&]() { m.get_key0_by_vogel_method(); });
+            
+            for(int k = 0; k < solveMethsNum; ++k) {
+                auto& t = r.timings[methodsNum - solveMethsNum + k];
+                // the Hungarian method takes nothing but assignments
+                t.skipped = over[k] || (solveMeths[k].meth == BalanceMatrix::Meth::Assignment && !inst.assignment);
+                if(!t.skipped) {
+                    BalanceMatrix::Options options;
+                    options.pricing = solveMeths[k].pricing;
+                    t = time_solve(m, solveMeths[k].meth, options);
+                    over[k] = t.seconds > budget;
+                }
+            }
+            r.peakRssKb = peak_rss_kb();
+            results.push_back(r);
+            
+            std::cout << std::left << std::setw(20) << r.instance << std::right << std::setw(6) << r.size;
+            for(auto const& t : r.timings) {
+                std::cout << std::setw(17);
+                if(t.skipped) std::cout << "-";
+                else std::cout << std::fixed << std::setprecision(4) << t.seconds;
+            }
+            std::cout << std::setw(8) << (r.timings[4].skipped ? -1 : r.timings[4].iterations)
+                      << std::setw(10) << r.peakRssKb << '\n';
+        }
+    }
+    
+    // the auction on the biggest balanced instance by the number of
+    // threads, doubling up to the hardware's
+    vector<Scaling> scaling;
+    if(!sizes.empty()) {
+        std::mt19937 gen {seed + static_cast<unsigned>(sizes.back())};
+        auto rows = uniform_balanced(gen, sizes.back());
+        
+        auto hardware = std::max(1u, std::thread::hardware_concurrency());
+        vector<unsigned> threadsNums;
+        for(auto n = 1u; n < hardware; n *= 2) {
+            threadsNums.push_back(n);
+        }
+        threadsNums.push_back(hardware);
+        
+        std::cout << "\nauction on uniform_balanced " << sizes.back() << ":\n";
+        std::cout << std::setw(8) << "threads" << std::setw(12) << "seconds" << std::setw(10) << "speedup" << '\n';
+        for(auto n : threadsNums) {
+            scaling.push_back(time_auction(rows, n));
+            std::cout << std::setw(8) << scaling.back().threadsNum
+                      << std::setw(12) << std::fixed << std::setprecision(4) << scaling.back().seconds
+                      << std::setw(10) << std::setprecision(2) << scaling.front().seconds / scaling.back().seconds << '\n';
+        }
+    }
+    
+    std::ofstream out {outPath};
+    write_json(out, results, scaling, seed);
+    std::cout << "results written to " << outPath << '\n';
+    
+    return out ? 0 : 1;
+}
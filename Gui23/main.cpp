@@ -5,10 +5,16 @@
 #include <wx/clipbrd.h>
 #include <wx/colour.h>
 #include <sstream>
+#include <thread>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
 
 class MyFrame : public wxFrame {
 public:
     MyFrame(char const* name);
+    ~MyFrame();
     
     void OnNewRestrButton(wxCommandEvent&);
     void OnDelRestrButton(wxCommandEvent&);
@@ -18,6 +24,14 @@ public:
     
     void ClearNotebooks();
     void FillNotebook(std::vector<Solver::Step> const& steps, wxNotebook* book);
+    
+    void StartSolving(Solver const& solver, bool dualView);
+    void StartSolvingDual(Solver const& invSolver);
+    void JoinSolveThread(std::thread::id id);
+    void PostSolveFailure(unsigned generation, wxString const& message);
+    void FailSolving(wxString const& message);
+    void CancelSolving();
+    Solver::Options SolveOptions() const;
 
 private:
     wxBoxSizer* restrSizer;
@@ -27,8 +41,15 @@ private:
     std::vector<wxTextCtrl*> restrEntries;
     
     std::vector<std::pair<wxGrid*, int>> stepsGrids;
+    wxCheckBox* dualStepsCheck;
     wxNotebook* directStepsBook;
     wxNotebook* invertStepsBook;
+    
+    // results of a solve started before the last edit are dropped,
+    // and the solve itself is told to stop between pivots
+    std::vector<std::thread> solveThreads;
+    unsigned solveGeneration = 0;
+    std::shared_ptr<std::atomic<bool>> solveCancel = std::make_shared<std::atomic<bool>>(false);
 };
 
 MyFrame::MyFrame(char const* name)
@@ -80,6 +101,8 @@ MyFrame::MyFrame(char const* name)
     
     mainSizer->Add(restrSizer, wxSizerFlags().Expand());
     
+    dualStepsCheck = new wxCheckBox(this, wxID_ANY, wxT("Шаги двойственной задачи"));
+    mainSizer->Add(dualStepsCheck, wxSizerFlags().Expand().Border(wxALL, 5));
     
     auto directStepsLabel = new wxStaticText(this, wxID_ANY, wxT("Прямая задача:"));
     mainSizer->Add(directStepsLabel, wxSizerFlags().Expand().Border(wxALL, 5));
@@ -104,7 +127,16 @@ MyFrame::MyFrame(char const* name)
     Center(wxBOTH);
 }
 
+MyFrame::~MyFrame() {
+    CancelSolving();
+    for(auto& t : solveThreads) {
+        t.join();
+    }
+}
+
 void MyFrame::on_text_change(wxCommandEvent& evt) {
+    CancelSolving();
+    
     if(!stepsGrids.empty()) {
         ClearNotebooks();
         mainSizer->SetSizeHints(this);
@@ -210,11 +242,14 @@ void MyFrame::FillNotebook(std::vector<Solver::Step> const& steps, wxNotebook* b
             page->SetCellValue(row, col++, to_string(step.goal.term(j)));
         }
         
-        // restrictions rows
+        // restrictions rows, a dual view has no basis column
         for(auto const& restr : step.restrs) {
             ++row;
             col = 0;
-            page->SetCellValue(row, col++, to_string(step.sel[row - 1]));
+            page->SetCellValue(
+                row, col++,
+                step.sel.empty() ? restr.rel() : to_string(step.sel[row - 1])
+            );
             page->SetCellValue(
                 row, col++, 
                 to_string(static_cast<fracType>(restr.right()))
@@ -241,6 +276,11 @@ void MyFrame::FillNotebook(std::vector<Solver::Step> const& steps, wxNotebook* b
                 to_string(static_cast<fracType>(step.pprice.coeff(fi)))
             );
         }
+        if(step.sel.empty()) {
+            for(auto const& t : step.basis) {
+                page->SetCellValue(row, col++, to_string(t));
+            }
+        }
         
         // mega price row
         if(needMPrice) {
@@ -286,21 +326,134 @@ void MyFrame::OnSolveButton(wxCommandEvent& evt) {
         }
     }
     
-    Solver invSolver = solver;
-    invSolver.invert_to_dual();
-    
-    auto steps = solver.solve();
-    auto invSteps = invSolver.solve();
+    CancelSolving();
+    ClearNotebooks();
     
-    if(!steps.back().valid()) {
-        wxMessageBox(wxT("Неразрешимая система"),
-                     wxT("Ошибка"), wxOK|wxCENTER|wxICON_ERROR);
-        return;
+    // the dual is read off the primal result, unless its own steps are wanted
+    bool dualSteps = dualStepsCheck->IsChecked();
+    if(dualSteps) {
+        Solver invSolver = solver;
+        invSolver.invert_to_dual();
+        StartSolvingDual(invSolver);
     }
-    
+    StartSolving(solver, !dualSteps);
+}
+
+void MyFrame::StartSolving(Solver const& solver, bool dualView) {
+    auto generation = solveGeneration;
+    auto options = SolveOptions();
+    
+    solveThreads.emplace_back([this, work = solver, dualView, generation, options, cancel = solveCancel]() mutable {
+        std::vector<Solver::Step> steps;
+        std::vector<Solver::Step> invSteps;
+        try {
+            steps = work.solve(options);
+            if(dualView && steps.back().valid()) {
+                invSteps.push_back(work.dual_step(steps.back()));
+            }
+        }
+        catch(std::overflow_error const&) {
+            PostSolveFailure(generation, wxT("Слишком большие числа в решении"));
+            return;
+        }
+        catch(std::exception const&) {
+            PostSolveFailure(generation, wxT("Ошибка при решении"));
+            return;
+        }
+        
+        auto id = std::this_thread::get_id();
+        CallAfter([this, steps, invSteps, generation, id]() {
+            JoinSolveThread(id);
+            if(generation != solveGeneration) return;
+            
+            if(!steps.back().valid()) {
+                // the dual of an unsolvable system isn't shown either
+                FailSolving(wxT("Неразрешимая система"));
+                return;
+            }
+            
+            FillNotebook(steps, directStepsBook);
+            if(!invSteps.empty()) {
+                FillNotebook(invSteps, invertStepsBook);
+            }
+        });
+    });
+}
+
+void MyFrame::StartSolvingDual(Solver const& invSolver) {
+    auto generation = solveGeneration;
+    auto options = SolveOptions();
+    
+    solveThreads.emplace_back([this, work = invSolver, generation, options, cancel = solveCancel]() mutable {
+        std::vector<Solver::Step> steps;
+        try {
+            steps = work.solve(options);
+        }
+        catch(std::overflow_error const&) {
+            PostSolveFailure(generation, wxT("Слишком большие числа в решении"));
+            return;
+        }
+        catch(std::exception const&) {
+            PostSolveFailure(generation, wxT("Ошибка при решении"));
+            return;
+        }
+        
+        auto id = std::this_thread::get_id();
+        CallAfter([this, steps, generation, id]() {
+            JoinSolveThread(id);
+            if(generation != solveGeneration) return;
+            
+            if(steps.back().status == Solver::Status::cancelled) return;
+            
+            FillNotebook(steps, invertStepsBook);
+        });
+    });
+}
+
+// no deadline, a long solve runs until an edit or a new solve cancels it
+Solver::Options MyFrame::SolveOptions() const {
+    Solver::Options options;
+    options.cancel = solveCancel.get();
+    return options;
+}
+
+// called on the solving thread, which can't let an exception out
+void MyFrame::PostSolveFailure(unsigned generation, wxString const& message) {
+    auto id = std::this_thread::get_id();
+    CallAfter([this, generation, id, message]() {
+        JoinSolveThread(id);
+        if(generation != solveGeneration) return;
+        
+        FailSolving(message);
+    });
+}
+
+// both notebooks are dropped, a half-shown result would mislead
+void MyFrame::FailSolving(wxString const& message) {
+    CancelSolving();
     ClearNotebooks();
-    FillNotebook(steps, directStepsBook);
-    FillNotebook(invSteps, invertStepsBook);
+    wxMessageBox(message, wxT("Ошибка"), wxOK|wxCENTER|wxICON_ERROR);
+}
+
+void MyFrame::CancelSolving() {
+    ++solveGeneration;
+    
+    // running threads hold their own reference to the old flag
+    solveCancel->store(true);
+    solveCancel = std::make_shared<std::atomic<bool>>(false);
+}
+
+void MyFrame::JoinSolveThread(std::thread::id id) {
+    auto it = std::find_if(solveThreads.begin(), solveThreads.end(),
+    [id](std::thread const& t) {
+        return t.get_id() == id;
+    });
+    
+    // the thread is done once it has queued its result
+    if(it != solveThreads.end()) {
+        it->join();
+        solveThreads.erase(it);
+    }
 }
 
 class MyApp : public wxApp {
@@ -192,9 +192,9 @@ void MyFrame::fill_notebook(vector<BalanceMatrix::Step> const& steps, wxNotebook
         auto page = new wxGrid(book, pageId);
         _stepGrids.emplace_back(page, pageId);
         
-        int rowsNum = step.X.size();
-        int colsXNum = step.X[0].size();
-        int colsDNum = step.D[0].size();
+        int rowsNum = step.X.rows();
+        int colsXNum = step.X.cols();
+        int colsDNum = step.D.cols();
         int colsNum = colsXNum + colsDNum + 1;
         
         page->CreateGrid(rowsNum + 2, colsNum);
@@ -209,16 +209,16 @@ void MyFrame::fill_notebook(vector<BalanceMatrix::Step> const& steps, wxNotebook
         page->SetCellValue(0, 0, "X:");
         page->SetCellValue(0, colsXNum + 1, "D:");
         page->SetCellValue(rowsNum + 1, 0, "W:");
-        page->SetCellValue(rowsNum + 1, 1, wxString::Format("%d", step.W));
+        page->SetCellValue(rowsNum + 1, 1, wxString::Format("%lld", step.W));
         
         for(int r = 0; r < rowsNum; ++r) {
             for(int c = 0; c < colsXNum; ++c) {
                 wxString formatStr = "%d";
-                if(step.X[r][c] < 0) formatStr += "E";
+                if(step.eps[r][c]) formatStr += "E";
                 
                 page->SetCellValue(
                     r + 1, c, 
-                    wxString::Format(formatStr, std::abs(step.X[r][c]))
+                    wxString::Format(formatStr, step.X[r][c])
                 );
             }
             
@@ -0,0 +1,68 @@
+#include "BatchSolver.h"
+#include <stdexcept>
+
+using std::vector;
+
+BatchSolver::BatchSolver(unsigned threadsNum) : _pool(threadsNum) {
+}
+
+unsigned BatchSolver::threads_num() const {
+    return _pool.size();
+}
+
+inline namespace helpers {
+    // only the last step is kept, earlier ones are dropped as they're passed;
+    // an overflow stays with its model instead of ending the whole batch
+    Solver::Step
+    last_step(Solver& solver, Solver::Options options, Solver::Stats* stats) {
+        options.stats = stats;
+        try {
+            auto steps = solver.solve_steps(options);
+            while(steps.next()) {}
+            return steps.current();
+        }
+        catch(std::overflow_error const&) {
+            Solver::Step failed;
+            failed.status = Solver::Status::overflow;
+            return failed;
+        }
+    }
+    
+    Solver::Stats* stats_of(vector<Solver::Stats>* stats, std::size_t i) {
+        return stats ? &(*stats)[i] : nullptr;
+    }
+}
+
+vector<Solver::Step> BatchSolver::solve(
+    vector<Model> const& models, Solver::Options const& options, vector<Solver::Stats>* stats
+) {
+    vector<Solver::Step> ret (models.size());
+    if(stats) stats->assign(models.size(), Solver::Stats {});
+    
+    _pool.for_each(models.size(), [&models, &options, &ret, stats](unsigned, std::size_t i) {
+        Solver solver;
+        if(!solver.set_goal(models[i].goal)) return;
+        for(auto const& r : models[i].restrs) {
+            if(!solver.add_restriction(r)) return;
+        }
+        
+        ret[i] = last_step(solver, options, stats_of(stats, i));
+    });
+    
+    return ret;
+}
+
+vector<Solver::Step> BatchSolver::solve(
+    vector<Solver> const& models, Solver::Options const& options, vector<Solver::Stats>* stats
+) {
+    vector<Solver::Step> ret (models.size());
+    if(stats) stats->assign(models.size(), Solver::Stats {});
+    
+    _pool.for_each(models.size(), [&models, &options, &ret, stats](unsigned, std::size_t i) {
+        // solving extends the table, so the caller's copy stays untouched
+        Solver solver = models[i];
+        ret[i] = last_step(solver, options, stats_of(stats, i));
+    });
+    
+    return ret;
+}
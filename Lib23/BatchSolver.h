@@ -0,0 +1,41 @@
+#ifndef BATCHSOLVER_H_INCLUDED
+#define BATCHSOLVER_H_INCLUDED
+
+#include "Solver.h"
+#include "ThreadPool.h"
+#include <string>
+#include <vector>
+
+class BatchSolver {
+public:
+    // 0 threads means one per hardware thread
+    explicit BatchSolver(unsigned threadsNum = 0);
+    
+    struct Model {
+        std::string              goal;
+        std::vector<std::string> restrs;
+    };
+    
+    // last step of every model, in input order;
+    // a model that fails to parse gets an invalid step, one that overflows
+    // gets an invalid step with the overflow status.
+    // options.stats is left alone, the workers would share it: stats,
+    // when given, gets one per model instead; the trace takes its own lock
+    std::vector<Solver::Step> solve(
+        std::vector<Model> const& models,
+        Solver::Options const& options = {},
+        std::vector<Solver::Stats>* stats = nullptr
+    );
+    std::vector<Solver::Step> solve(
+        std::vector<Solver> const& models,
+        Solver::Options const& options = {},
+        std::vector<Solver::Stats>* stats = nullptr
+    );
+    
+    unsigned threads_num() const;
+
+private:
+    ThreadPool _pool;
+};
+
+#endif
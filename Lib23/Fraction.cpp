@@ -3,6 +3,38 @@
 #include <iostream>
 #include <boost/math/common_factor_rt.hpp>
 
+inline namespace helpers {
+    thread_local unsigned long long gcdCalls = 0;
+    
+    Fraction::int_t
+    counted_gcd(Fraction::int_t a, Fraction::int_t b) {
+        ++gcdCalls;
+        return boost::math::gcd(a, b);
+    }
+    
+    // int_t that wraps around would leave a wrong fraction, so it throws
+    Fraction::int_t
+    checked_mul(Fraction::int_t a, Fraction::int_t b) {
+        Fraction::int_t ret;
+        if(__builtin_mul_overflow(a, b, &ret)) throw std::overflow_error("fraction overflow");
+        return ret;
+    }
+    
+    Fraction::int_t
+    checked_add(Fraction::int_t a, Fraction::int_t b) {
+        Fraction::int_t ret;
+        if(__builtin_add_overflow(a, b, &ret)) throw std::overflow_error("fraction overflow");
+        return ret;
+    }
+    
+    // only ever taken of denominators, which are positive
+    Fraction::int_t
+    counted_lcm(Fraction::int_t a, Fraction::int_t b) {
+        ++gcdCalls;
+        return checked_mul(a / boost::math::gcd(a, b), b);
+    }
+}
+
 Fraction::Fraction(int_t n, int_t d) : _num(n), _den(d) {
     if(d == 0) throw std::domain_error("zero denominator");
     simplify();
@@ -14,6 +46,10 @@ Fraction::Fraction(int_t n) : _num(n) {
 Fraction::int_t Fraction::num() const { return _num; }
 Fraction::int_t Fraction::den() const { return _den; }
 
+unsigned long long Fraction::gcd_calls() {
+    return gcdCalls;
+}
+
 float Fraction::as_float() const {
     return static_cast<float>(_num) / _den;
 }
@@ -24,16 +60,16 @@ Fraction::operator float() const {
 
 // Unary operators
 Fraction Fraction::operator-() const {
-    return Fraction(-_num, _den);
+    return Fraction(checked_mul(_num, -1), _den);
 }
 
 // w Fractions operators
 Fraction Fraction::operator +(Fraction o) const {
     Fraction res = *this;
-    int_t lcm = boost::math::lcm(res._den, o._den);
-    res._num *= lcm / res._den;
-    o._num *= lcm / o._den;
-    res._num += o._num;
+    int_t lcm = counted_lcm(res._den, o._den);
+    res._num = checked_mul(res._num, lcm / res._den);
+    o._num = checked_mul(o._num, lcm / o._den);
+    res._num = checked_add(res._num, o._num);
     res._den = lcm;
     res.simplify();
     return res;
@@ -41,14 +77,14 @@ Fraction Fraction::operator +(Fraction o) const {
 
 Fraction Fraction::operator *(Fraction o) const {
     Fraction res = *this;
-    int_t gcd1 = boost::math::gcd(res._num, o._den);
-    int_t gcd2 = boost::math::gcd(res._den, o._num);
+    int_t gcd1 = counted_gcd(res._num, o._den);
+    int_t gcd2 = counted_gcd(res._den, o._num);
     res._num /= gcd1;
     res._den /= gcd2;
     o._den /= gcd1;
     o._num /= gcd2;
-    res._num *= o._num;
-    res._den *= o._den;
+    res._num = checked_mul(res._num, o._num);
+    res._den = checked_mul(res._den, o._den);
     res.simplify();
     return res;
 }
@@ -66,9 +102,9 @@ bool Fraction::operator ==(Fraction o) const {
 }
 
 bool Fraction::operator <(Fraction o) const {
-    int_t lcm = boost::math::lcm(_den, o._den);
-    int_t tnum = _num * (lcm / _den);
-    int_t onum = o._num * (lcm / o._den);
+    int_t lcm = counted_lcm(_den, o._den);
+    int_t tnum = checked_mul(_num, lcm / _den);
+    int_t onum = checked_mul(o._num, lcm / o._den);
     return tnum < onum;
 }
 
@@ -113,20 +149,20 @@ Fraction& Fraction::operator =(int_t v) {
 
 Fraction Fraction::operator +(int_t v) const {
     Fraction res = *this;
-    res._num += v * res._den;
+    res._num = checked_add(res._num, checked_mul(v, res._den));
     res.simplify();
     return res;
 }
 
 Fraction Fraction::operator *(int_t v) const {
     Fraction res = *this;
-    res._num *= v;
+    res._num = checked_mul(res._num, v);
     res.simplify();
     return res;
 }
 
 Fraction Fraction::operator -(int_t v) const {
-    return *this + -v;
+    return *this + checked_mul(v, -1);
 }
 
 Fraction Fraction::operator /(int_t v) const {
@@ -203,7 +239,7 @@ void Fraction::simplify() {
     normalize();
     if(_num == 0) return;
     
-    int_t gcd = boost::math::gcd(_num, _den);
+    int_t gcd = counted_gcd(_num, _den);
     _num /= gcd;
     _den /= gcd;
 }
@@ -3,6 +3,7 @@
 
 #include <iosfwd>
 
+// arithmetic that doesn't fit int_t throws std::overflow_error
 class Fraction {
 public:
     using int_t = long;
@@ -16,6 +17,9 @@ public:
     
     float as_float() const;
     explicit operator float() const;
+    
+    // gcd and lcm evaluations made on the calling thread so far
+    static unsigned long long gcd_calls();
 
     // Unary operators
     Fraction operator -() const;
@@ -2,6 +2,7 @@
 
 #include <sstream>
 #include <iostream>
+#include <algorithm>
 
 static bool is_sign(char ch) { return ch == '+' || ch == '-'; }
 static bool    is_x(char ch) { return ch == 'x' || ch == 'X'; }
@@ -164,7 +165,7 @@ void Polynom::add_term(Term const& t) {
 }
 
 void Polynom::remove_term(int idx) {
-    for(int i = idx - 1; i >= 0; --i) {
+    for(int i = std::min(idx, size()) - 1; i >= 0; --i) {
         if(_terms[i].idx() == idx) {
             _terms.erase(_terms.begin() + i);
             break;
@@ -173,7 +174,7 @@ void Polynom::remove_term(int idx) {
 }
 
 Term const& Polynom::term(int idx) const {
-    for(int i = idx - 1; i >= 0; --i) {
+    for(int i = std::min(idx, size()) - 1; i >= 0; --i) {
         if(_terms[i].idx() == idx) {
             return _terms[i];
         }
@@ -186,7 +187,7 @@ std::vector<Term> const& Polynom::terms() const {
 }
 
 Fraction& Polynom::coeff(int idx) {
-    for(int i = idx - 1; i >= 0; --i) {
+    for(int i = std::min(idx, size()) - 1; i >= 0; --i) {
         if(_terms[i].idx() == idx) {
             return _terms[i].coeff();
         }
@@ -195,7 +196,7 @@ Fraction& Polynom::coeff(int idx) {
 }
 
 Fraction const& Polynom::coeff(int idx) const{
-    for(int i = idx - 1; i >= 0; --i) {
+    for(int i = std::min(idx, size()) - 1; i >= 0; --i) {
         if(_terms[i].idx() == idx) {
             return _terms[i].coeff();
         }
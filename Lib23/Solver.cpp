@@ -1,6 +1,7 @@
 #include "Solver.h"
 #include "Goal.h"
 #include "Restriction.h"
+#include "Trace.h"
 
 #include <iostream>
 #include <iomanip>
@@ -78,7 +79,10 @@ bool Solver::add_restriction(std::string const& str) {
 }
 
 void Solver::append_preferred() {
+    _initialRels.clear();
     for(auto& r : _restrs) {
+        _initialRels.push_back(r.rel());
+        
         if(r.rel() != "==") {
             r.add_term(
                 r.next_idx(),
@@ -309,6 +313,13 @@ inline namespace helpers {
         
         return 0;
     }
+    
+    // whether the step's goal, its M part first, is past the best so far
+    bool
+    improves(Solver::Step const& s, std::pair<Fraction, Fraction> const& best) {
+        auto goal = std::make_pair(s.m, s.w);
+        return s.goal.right() == "min" ? goal < best : best < goal;
+    }
 
     void 
     pack_end_results(Solver::Step& lastStep, vector<int> const& indices) {
@@ -376,7 +387,7 @@ inline namespace helpers {
         auto const rowsNum = range.size();
         
         auto it = range.cbegin();
-        while(!*it && it != range.cend()) {
+        while(it != range.cend() && !*it) {
             ++it;
         }
         
@@ -484,44 +495,223 @@ inline namespace helpers {
         return next;
     }
 
-    bool 
-    step_is_unique(Solver::Step const& step, vector<Solver::Step> const& steps) {
-        for(auto const& s : steps) {
-            if(step == s) {
-                return false;
+    bool
+    has_term(Polynom const& p, int idx) {
+        for(auto const& t : p.terms()) {
+            if(t.idx() == idx) return true;
+        }
+        return false;
+    }
+    
+    // adds the time spent in its scope to the target, if there's one
+    class PhaseTimer {
+    public:
+        explicit PhaseTimer(std::chrono::nanoseconds* target)
+        : _target {target}
+        {
+            if(_target) _start = std::chrono::steady_clock::now();
+        }
+        
+        ~PhaseTimer() {
+            if(_target) *_target += std::chrono::steady_clock::now() - _start;
+        }
+        
+    private:
+        std::chrono::nanoseconds* _target;
+        std::chrono::steady_clock::time_point _start;
+    };
+    
+    unsigned
+    bit_length(Fraction::int_t v) {
+        auto u = v < 0 ? 0ul - static_cast<unsigned long>(v) : static_cast<unsigned long>(v);
+        
+        unsigned ret = 0;
+        for(; u != 0; u >>= 1) {
+            ++ret;
+        }
+        return ret;
+    }
+    
+    void
+    track_bits(Solver::Stats& stats, Fraction const& f) {
+        stats.maxNumBits = std::max(stats.maxNumBits, bit_length(f.num()));
+        stats.maxDenBits = std::max(stats.maxDenBits, bit_length(f.den()));
+    }
+    
+    void
+    track_bits(Solver::Stats& stats, Solver::Step const& s) {
+        for(auto const& r : s.restrs) {
+            for(auto const& t : r.terms()) {
+                track_bits(stats, t.coeff());
             }
+            track_bits(stats, r.right());
         }
-        return true;
+        track_bits(stats, s.w);
+        track_bits(stats, s.m);
+    }
+    
+    // gauss-jordan over a consistent system, empty if it's underdetermined
+    vector<Fraction>
+    solve_linear(vector<vector<Fraction>> rows, vector<Fraction> rhs, unsigned unknowns) {
+        auto const rowsNum = rows.size();
+        
+        for(auto col = 0u; col < unknowns; ++col) {
+            auto pivot = col;
+            while(pivot < rowsNum && rows[pivot][col] == 0) {
+                ++pivot;
+            }
+            if(pivot == rowsNum) {
+                return {};
+            }
+            std::swap(rows[pivot], rows[col]);
+            std::swap(rhs[pivot], rhs[col]);
+            
+            auto divisor = rows[col][col];
+            for(auto& a : rows[col]) {
+                a /= divisor;
+            }
+            rhs[col] /= divisor;
+            
+            for(auto row = 0u; row < rowsNum; ++row) {
+                if(row == col || rows[row][col] == 0) continue;
+                
+                auto factor = rows[row][col];
+                for(auto j = 0u; j < unknowns; ++j) {
+                    rows[row][j] -= factor * rows[col][j];
+                }
+                rhs[row] -= factor * rhs[col];
+            }
+        }
+        
+        rhs.resize(unknowns);
+        return rhs;
     }
 }
 
 
 
 vector<Solver::Step> Solver::solve() {
-    append_preferred();
-    append_artificial();
+    return solve(Options{});
+}
+
+vector<Solver::Step> Solver::solve(Options const& options) {
+    Trace::Span span {options.trace, "solve"};
     
-    // setup
     vector<Step> steps;
-    Step s;
-    s.goal   = _goal;
-    s.sel    = _sel;
-    s.restrs = _restrs;
-    s.pprice.add_term(_goal.last_idx());
-    s.mprice.add_term(_goal.last_idx());
-    
-    while(true) {
+    for(auto const& s : solve_steps(options)) {
+        steps.push_back(s);
+        if(options.stats) ++options.stats->stepCopies;
+    }
+    return steps;
+}
+
+Solver::Steps Solver::solve_steps() {
+    return solve_steps(Options{});
+}
+
+Solver::Steps Solver::solve_steps(Options const& options) {
+    {
+        Trace::Span span {options.trace, "append_preferred"};
+        append_preferred();
+    }
+    {
+        Trace::Span span {options.trace, "append_artificial"};
+        append_artificial();
+    }
+    
+    return Steps {*this, options};
+}
+
+Solver::Steps::Steps(Solver const& solver, Options const& options)
+: _options      {options}
+, _initialBasis {solver._initialBasis}
+, _rowsNum      (solver._restrs.size())
+{
+    Trace::Span span {_options.trace, "setup"};
+    
+    if(_options.stats) {
+        *_options.stats = Stats {};
+    }
+    
+    // setup
+    _step.goal   = solver._goal;
+    _step.sel    = solver._sel;
+    _step.restrs = solver._restrs;
+    _step.pprice.add_term(solver._goal.last_idx());
+    _step.mprice.add_term(solver._goal.last_idx());
+}
+
+bool Solver::Steps::next() {
+    if(_finished) {
+        _exhausted = true;
+        return false;
+    }
+    
+    auto stats = _options.stats;
+    if(!stats) {
+        produce(nullptr);
+        return true;
+    }
+    
+    Stats::Iteration it;
+    auto gcdCalls = Fraction::gcd_calls();
+    produce(&it);
+    it.gcdCalls = Fraction::gcd_calls() - gcdCalls;
+    
+    stats->gcdCalls += it.gcdCalls;
+    if(it.degenerate) ++stats->degeneratePivots;
+    track_bits(*stats, _step);
+    stats->iterations.push_back(it);
+    return true;
+}
+
+void Solver::Steps::produce(Stats::Iteration* it) {
+    auto trace = _options.trace;
+    Trace::Span iterationSpan {trace, "iteration", static_cast<int>(_iterations)};
+    
+    if(_started) {
+        // strip out M columns, switch selected rows and calculate new table
+        Trace::Span span {trace, "pivot"};
+        PhaseTimer timer {it ? &it->pivot : nullptr};
+        _step = advance_step(_step, _selCol, _selRow);
+        if(it) ++_options.stats->stepCopies;
+    }
+    _started = true;
+    
+    auto& s = _step;
+    {
+        Trace::Span span {trace, "pricing"};
+        PhaseTimer timer {it ? &it->pricing : nullptr};
         calculate_price(s);
-        // if the step repeats itself, it's unsolvable
-        if(!step_is_unique(s, steps)) {
-            steps.push_back(s);
-            break;
+    }
+    
+    // if the step repeats itself, it's unsolvable;
+    // the basis and the columns left decide the whole table.
+    // The steps don't always move the goal the right way, but a cycle
+    // can't pass a new best twice, so the steps before one are dropped
+    bool repeated;
+    {
+        Trace::Span span {trace, "cycle_check"};
+        PhaseTimer timer {it ? &it->cycleCheck : nullptr};
+        if(_seen.empty() || improves(s, _best)) {
+            _seen.clear();
+            _best = std::make_pair(s.m, s.w);
         }
-        else {
-            steps.push_back(s);
+        vector<int> key = s.goal.indices();
+        for(auto const& t : s.sel) {
+            key.push_back(t.idx());
         }
-        
-        int selCol = 0;
+        repeated = !_seen.insert(std::move(key)).second;
+    }
+    if(repeated) {
+        s.status = Status::cycled;
+        _finished = true;
+        return;
+    }
+    
+    int selCol = 0;
+    {
+        Trace::Span span {trace, "select_column"};
         if(need_to_calc_artificial(s)) {
             selCol = select_column(s, true);
         }
@@ -529,23 +719,298 @@ vector<Solver::Step> Solver::solve() {
         if(selCol == 0) {
             selCol = select_column(s, false);
         }
-        // if again no column selected, it's a finish
-        if(selCol == 0) {
-            pack_end_results(steps.back(), _initialBasis);
-            break;
+    }
+    // if again no column selected, it's a finish
+    if(selCol == 0) {
+        pack_end_results(s, _initialBasis);
+        // an artificial variable left in the basis means there's no solution
+        s.status = need_to_calc_artificial(s) ? Status::infeasible : Status::optimal;
+        _finished = true;
+        return;
+    }
+    
+    unsigned selRow;
+    {
+        Trace::Span span {trace, "ratio_test"};
+        PhaseTimer timer {it ? &it->ratioTest : nullptr};
+        selRow = select_row(s, selCol);
+    }
+    // if no row selected, it's unsolvable
+    if(selRow == _rowsNum) {
+        s.status = Status::unbounded;
+        _finished = true;
+        return;
+    }
+    
+    if(_options.cancel && _options.cancel->load()) {
+        s.status = Status::cancelled;
+        _finished = true;
+        return;
+    }
+    if((_options.maxIterations != 0 && _iterations == _options.maxIterations) ||
+       std::chrono::steady_clock::now() >= _options.deadline)
+    {
+        s.status = Status::limit;
+        _finished = true;
+        return;
+    }
+    ++_iterations;
+    
+    if(it) it->degenerate = s.restrs[selRow].right() == 0;
+    _selCol = selCol;
+    _selRow = selRow;
+}
+
+Solver::Step const& Solver::Steps::current() const {
+    return _step;
+}
+
+Solver::Steps::iterator Solver::Steps::begin() {
+    if(!_started) next();
+    return _exhausted ? end() : iterator {this};
+}
+
+Solver::Steps::iterator Solver::Steps::end() {
+    return iterator {};
+}
+
+Solver::Steps::iterator::iterator(Steps* steps)
+: _steps {steps}
+{}
+
+Solver::Step const& Solver::Steps::iterator::operator *() const {
+    return _steps->current();
+}
+
+Solver::Step const* Solver::Steps::iterator::operator ->() const {
+    return &_steps->current();
+}
+
+Solver::Steps::iterator& Solver::Steps::iterator::operator ++() {
+    if(!_steps->next()) {
+        _steps = nullptr;
+    }
+    return *this;
+}
+
+bool Solver::Steps::iterator::operator ==(iterator const& o) const {
+    return _steps == o._steps;
+}
+
+bool Solver::Steps::iterator::operator !=(iterator const& o) const {
+    return !(*this == o);
+}
+
+vector<Fraction> Solver::multipliers(Step const& last) const {
+    if(!last.valid()) return {};
+    
+    auto const rowsNum = _restrs.size();
+    vector<Fraction> duals (rowsNum);
+    vector<unsigned> unknown;
+    
+    // a row's starting unit column is priced at its multiplier minus the column cost
+    for(auto row = 0u; row < rowsNum; ++row) {
+        int col = _sel[row].idx();
+        if(has_term(last.goal, col)) {
+            duals[row] = last.pprice.coeff(col);
+            if(!_sel[row].big()) {
+                duals[row] += _sel[row].coeff();
+            }
+        }
+        else {
+            unknown.push_back(row);
         }
+    }
+    
+    // artificial columns are stripped once they leave the basis,
+    // so the rest comes from the basic columns, where the price is zero
+    if(!unknown.empty()) {
+        vector<vector<Fraction>> rows;
+        vector<Fraction> rhs;
         
-        auto selRow = select_row(s, selCol);
-        // if no row selected, it's unsolvable
-        if(selRow == _restrs.size()) {
-            break;
+        for(auto const& t : last.sel) {
+            vector<Fraction> row;
+            Fraction right = t.big() ? Fraction{} : t.coeff();
+            
+            for(auto i = 0u; i < rowsNum; ++i) {
+                auto a = _restrs[i].coeff(t.idx());
+                if(std::find(unknown.begin(), unknown.end(), i) != unknown.end()) {
+                    row.push_back(a);
+                }
+                else {
+                    right -= duals[i] * a;
+                }
+            }
+            
+            rows.push_back(row);
+            rhs.push_back(right);
         }
         
-        // strip out M columns, switch selected rows and calculate new table
-        s = advance_step(s, selCol, selRow);
+        auto solved = solve_linear(rows, rhs, unknown.size());
+        if(solved.empty()) return {};
+        
+        for(auto k = 0u; k < unknown.size(); ++k) {
+            duals[unknown[k]] = solved[k];
+        }
     }
     
-    return steps;
+    return duals;
+}
+
+vector<Fraction> Solver::dual_values(Step const& last) const {
+    auto duals = multipliers(last);
+    if(duals.empty()) return {};
+    
+    // match the signs of the variables invert_to_dual() would produce
+    std::string flippedRel = (_goal.right() == "min" ? "<=" : ">=");
+    for(auto row = 0u; row < duals.size(); ++row) {
+        if(_initialRels[row] == flippedRel) {
+            duals[row] = -duals[row];
+        }
+    }
+    
+    return duals;
+}
+
+Solver::Step Solver::dual_step(Step const& last) const {
+    Step ret;
+    
+    auto duals = dual_values(last);
+    if(duals.empty()) return ret;
+    
+    Solver dual = original_problem();
+    dual.invert_to_dual();
+    
+    ret.goal   = dual._goal;
+    ret.restrs = dual._restrs;
+    for(auto i = 0u; i < duals.size(); ++i) {
+        ret.basis.push_back(Term{static_cast<int>(i) + 1, duals[i]});
+    }
+    ret.w = last.w;
+    ret.mark_as_valid();
+    
+    return ret;
+}
+
+vector<Fraction> Solver::inverse_column(Step const& last, unsigned row) const {
+    auto const rowsNum = _restrs.size();
+    
+    // the starting unit column of the row has been carried along the steps
+    int col = _sel[row].idx();
+    if(has_term(last.goal, col)) {
+        return get_col(last, col);
+    }
+    
+    // otherwise solve against the basic columns of the original table
+    vector<vector<Fraction>> rows (rowsNum);
+    vector<Fraction> rhs (rowsNum);
+    for(auto r = 0u; r < rowsNum; ++r) {
+        for(auto const& t : last.sel) {
+            rows[r].push_back(_restrs[r].coeff(t.idx()));
+        }
+    }
+    rhs[row] = 1;
+    
+    return solve_linear(rows, rhs, rowsNum);
+}
+
+Solver::Sensitivity Solver::sensitivity(Step const& last) const {
+    Sensitivity ret;
+    
+    ret.prices = multipliers(last);
+    if(ret.prices.empty()) return ret;
+    
+    auto const rowsNum = _restrs.size();
+    
+    // right sides: the basic values move along the inverse column and stay positive
+    for(auto row = 0u; row < rowsNum; ++row) {
+        auto beta = inverse_column(last, row);
+        Sensitivity::Range range;
+        
+        for(auto k = 0u; k < beta.size(); ++k) {
+            if(beta[k] == 0) continue;
+            
+            auto delta = -last.restrs[k].right() / beta[k];
+            if(beta[k] > 0) {
+                if(!range.lower || delta > *range.lower) range.lower = delta;
+            }
+            else {
+                if(!range.upper || delta < *range.upper) range.upper = delta;
+            }
+        }
+        
+        auto right = _restrs[row].right();
+        if(range.lower) *range.lower += right;
+        if(range.upper) *range.upper += right;
+        ret.rhs.push_back(range);
+    }
+    
+    // costs: prices of the non basic columns must keep their sign
+    bool minimize = (_goal.right() == "min");
+    for(int j : _initialBasis) {
+        Sensitivity::Range range;
+        
+        auto basicRow = rowsNum;
+        for(auto row = 0u; row < rowsNum; ++row) {
+            if(last.sel[row].idx() == j) basicRow = row;
+        }
+        
+        if(basicRow == rowsNum) {
+            auto bound = last.pprice.coeff(j);
+            if(minimize) range.lower = bound;
+            else         range.upper = bound;
+        }
+        else {
+            for(int k : last.goal.indices()) {
+                if(last.goal.big(k) || k == j) continue;
+                
+                auto a = last.restrs[basicRow].coeff(k);
+                if(a == 0) continue;
+                
+                auto delta = -last.pprice.coeff(k) / a;
+                if((a > 0) == minimize) {
+                    if(!range.upper || delta < *range.upper) range.upper = delta;
+                }
+                else {
+                    if(!range.lower || delta > *range.lower) range.lower = delta;
+                }
+            }
+        }
+        
+        auto cost = _goal.coeff(j);
+        if(range.lower) *range.lower += cost;
+        if(range.upper) *range.upper += cost;
+        ret.costs.push_back(range);
+    }
+    
+    return ret;
+}
+
+bool Solver::Sensitivity::valid() const {
+    return !prices.empty();
+}
+
+Solver Solver::original_problem() const {
+    Solver ret;
+    
+    ret._goal.right(_goal.right());
+    for(int i : _initialBasis) {
+        ret._goal.add_term(_goal.term(i));
+    }
+    
+    for(auto row = 0u; row < _restrs.size(); ++row) {
+        Restriction r;
+        for(int i : _initialBasis) {
+            r.add_term(_restrs[row].term(i));
+        }
+        r.right() = _restrs[row].right();
+        r.rel(_initialRels.empty() ? _restrs[row].rel() : _initialRels[row]);
+        
+        ret._restrs.push_back(r);
+    }
+    ret._initialBasis = _initialBasis;
+    
+    return ret;
 }
 
 bool Solver::Step::valid() const {
@@ -593,3 +1058,29 @@ std::ostream& operator <<(std::ostream& os, Solver::Step const& s) {
     os << "</mprice>\n</Step>";
     return os;
 }
+
+std::ostream& write_json(std::ostream& os, Solver::Stats const& stats) {
+    if(!std::ostream::sentry {os}) return os;
+    
+    os << "{\"gcd_calls\":" << stats.gcdCalls
+       << ",\"step_copies\":" << stats.stepCopies
+       << ",\"degenerate_pivots\":" << stats.degeneratePivots
+       << ",\"max_num_bits\":" << stats.maxNumBits
+       << ",\"max_den_bits\":" << stats.maxDenBits
+       << ",\"iterations\":[";
+    
+    auto sep = "";
+    for(auto const& it : stats.iterations) {
+        os << sep
+           << "{\"pivot_ns\":" << it.pivot.count()
+           << ",\"pricing_ns\":" << it.pricing.count()
+           << ",\"cycle_check_ns\":" << it.cycleCheck.count()
+           << ",\"ratio_test_ns\":" << it.ratioTest.count()
+           << ",\"gcd_calls\":" << it.gcdCalls
+           << ",\"degenerate\":" << (it.degenerate ? "true" : "false")
+           << "}";
+        sep = ",";
+    }
+    
+    return os << "]}";
+}
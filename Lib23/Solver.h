@@ -4,6 +4,12 @@
 #include "Goal.h"
 #include "Restriction.h"
 #include <vector>
+#include <set>
+#include <atomic>
+#include <chrono>
+#include <boost/optional.hpp>
+
+class Trace;
 
 class Solver {
 public:
@@ -14,18 +20,72 @@ public:
     Solver& invert_to_dual();
     
     struct Step;
+    struct Sensitivity;
+    struct Options;
+    struct Stats;
+    enum class Status;
+    class Steps;
     std::vector<Step> solve();
+    std::vector<Step> solve(Options const& options);
+    
+    // same steps as solve(), produced one at a time while iterating
+    Steps solve_steps();
+    Steps solve_steps(Options const& options);
+    
+    // dual problem answers, read from the last step of a finished solve();
+    // the dual step holds the dual goal, restrs, basis and w, but no tableau
+    std::vector<Fraction> dual_values(Step const& last) const;
+    Step dual_step(Step const& last) const;
+    Sensitivity sensitivity(Step const& last) const;
     
     friend std::ostream& operator<<(std::ostream& os, Solver const& solver);
 
 private:
     void append_preferred();
     void append_artificial();
+    Solver original_problem() const;
+    std::vector<Fraction> multipliers(Step const& last) const;
+    std::vector<Fraction> inverse_column(Step const& last, unsigned row) const;
     
     Goal                     _goal;
     std::vector<Term>        _sel;
     std::vector<Restriction> _restrs;
     std::vector<int>         _initialBasis;
+    std::vector<std::string> _initialRels;
+};
+
+// why the last step ended the solve; solving throws std::overflow_error
+// when a fraction outgrows its int_t, only BatchSolver reports overflow
+enum class Solver::Status {
+    none, optimal, infeasible, unbounded, cycled, limit, cancelled, overflow
+};
+
+// limits are checked between pivots
+struct Solver::Options {
+    unsigned maxIterations = 0; // 0 means no limit
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    std::atomic<bool> const* cancel = nullptr;
+    Stats* stats = nullptr; // filled in while solving when set
+    Trace* trace = nullptr; // gets a span per phase when set
+};
+
+// where the time of a solve went, one entry per produced step
+struct Solver::Stats {
+    struct Iteration {
+        std::chrono::nanoseconds pivot {0}; // building this step from the previous
+        std::chrono::nanoseconds pricing {0};
+        std::chrono::nanoseconds cycleCheck {0};
+        std::chrono::nanoseconds ratioTest {0};
+        unsigned long long       gcdCalls = 0;
+        bool                     degenerate = false; // the next pivot keeps w
+    };
+    
+    std::vector<Iteration> iterations;
+    unsigned long long     gcdCalls = 0;
+    unsigned long long     stepCopies = 0; // every copy reallocates the whole table
+    unsigned               degeneratePivots = 0;
+    unsigned               maxNumBits = 0;
+    unsigned               maxDenBits = 0;
 };
 
 class Solver::Step {
@@ -38,6 +98,7 @@ public:
     std::vector<Term>        basis;
     Fraction                 w;
     Fraction                 m;
+    Status                   status = Status::none;
     
     bool valid() const;
     void mark_as_valid();
@@ -48,6 +109,76 @@ private:
     bool _valid = false;
 };
 
+// single pass range, each step is computed when the iterator advances;
+// doesn't refer back to the solver it came from
+class Solver::Steps {
+public:
+    class iterator;
+    
+    iterator begin();
+    iterator end();
+    
+    // false once the last step has been produced
+    bool next();
+    Step const& current() const;
+    
+private:
+    friend class Solver;
+    Steps(Solver const& solver, Options const& options);
+    void produce(Stats::Iteration* it);
+    
+    Step                    _step;
+    Options                 _options;
+    std::vector<int>        _initialBasis;
+    std::set<std::vector<int>> _seen; // goal and basis indices of the steps
+                                      // since the goal was last at its best
+    std::pair<Fraction, Fraction> _best; // m and w of that step
+    unsigned                _rowsNum = 0;
+    unsigned                _iterations = 0;
+    int                     _selCol = 0;
+    unsigned                _selRow = 0;
+    bool                    _started = false;
+    bool                    _finished = false;
+    bool                    _exhausted = false;
+};
+
+class Solver::Steps::iterator {
+public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type        = Step;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = Step const*;
+    using reference         = Step const&;
+    
+    iterator() = default;
+    explicit iterator(Steps* steps);
+    
+    reference operator *() const;
+    pointer operator ->() const;
+    iterator& operator ++();
+    
+    bool operator ==(iterator const& o) const;
+    bool operator !=(iterator const& o) const;
+    
+private:
+    Steps* _steps = nullptr;
+};
+
+// how far the data may move before the last step's basis changes
+struct Solver::Sensitivity {
+    struct Range {
+        boost::optional<Fraction> lower; // none if unbounded
+        boost::optional<Fraction> upper;
+    };
+    
+    std::vector<Fraction> prices; // shadow price of each restriction
+    std::vector<Range>    rhs;    // right side of each restriction
+    std::vector<Range>    costs;  // goal coefficient of each initial variable
+    
+    bool valid() const;
+};
+
 std::ostream& operator <<(std::ostream& os, Solver::Step const& s);
+std::ostream& write_json(std::ostream& os, Solver::Stats const& stats);
 
 #endif
@@ -0,0 +1,129 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threadsNum) {
+    if(threadsNum == 0) {
+        threadsNum = std::max(1u, std::thread::hardware_concurrency());
+    }
+    
+    for(auto i = 0u; i < threadsNum; ++i) {
+        _queues.emplace_back(new Queue);
+    }
+    for(auto i = 0u; i < threadsNum; ++i) {
+        _threads.emplace_back(&ThreadPool::work, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock {_mutex};
+        _stop = true;
+    }
+    _wake.notify_all();
+    
+    for(auto& t : _threads) {
+        t.join();
+    }
+}
+
+unsigned ThreadPool::size() const {
+    return static_cast<unsigned>(_threads.size());
+}
+
+void ThreadPool::for_each(std::size_t count, Job const& job) {
+    if(count == 0) return;
+    
+    _job = &job;
+    _error = nullptr;
+    _pending = count;
+    
+    // hand out contiguous blocks, stealing evens them out later
+    auto const queuesNum = _queues.size();
+    for(auto q = 0u; q < queuesNum; ++q) {
+        auto first = count * q / queuesNum;
+        auto last  = count * (q + 1) / queuesNum;
+        
+        std::lock_guard<std::mutex> lock {_queues[q]->mutex};
+        for(auto i = first; i < last; ++i) {
+            _queues[q]->items.push_back(i);
+        }
+    }
+    
+    std::unique_lock<std::mutex> lock {_mutex};
+    ++_generation;
+    _wake.notify_all();
+    _done.wait(lock, [this]{ return _pending == 0; });
+    
+    _job = nullptr;
+    if(_error) {
+        std::rethrow_exception(_error);
+    }
+}
+
+void ThreadPool::work(unsigned worker) {
+    std::size_t seen = 0;
+    
+    while(true) {
+        {
+            std::unique_lock<std::mutex> lock {_mutex};
+            _wake.wait(lock, [this, seen]{ return _stop || _generation != seen; });
+            if(_stop) return;
+            seen = _generation;
+        }
+        
+        std::size_t item;
+        while(pop(worker, item) || steal(worker, item)) {
+            try {
+                (*_job)(worker, item);
+            }
+            catch(...) {
+                std::lock_guard<std::mutex> lock {_mutex};
+                if(!_error) _error = std::current_exception();
+            }
+            
+            if(_pending.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock {_mutex};
+                _done.notify_all();
+            }
+        }
+    }
+}
+
+bool ThreadPool::pop(unsigned worker, std::size_t& item) {
+    auto& q = *_queues[worker];
+    std::lock_guard<std::mutex> lock {q.mutex};
+    
+    if(q.items.empty()) return false;
+    item = q.items.front();
+    q.items.pop_front();
+    return true;
+}
+
+bool ThreadPool::steal(unsigned worker, std::size_t& item) {
+    auto const queuesNum = _queues.size();
+    
+    for(auto offset = 1u; offset < queuesNum; ++offset) {
+        auto& victim = *_queues[(worker + offset) % queuesNum];
+        
+        std::deque<std::size_t> loot;
+        {
+            std::lock_guard<std::mutex> lock {victim.mutex};
+            auto half = (victim.items.size() + 1) / 2;
+            auto from = victim.items.end() - half;
+            loot.assign(from, victim.items.end());
+            victim.items.erase(from, victim.items.end());
+        }
+        if(loot.empty()) continue;
+        
+        item = loot.front();
+        loot.pop_front();
+        
+        auto& own = *_queues[worker];
+        std::lock_guard<std::mutex> lock {own.mutex};
+        own.items.insert(own.items.end(), loot.begin(), loot.end());
+        return true;
+    }
+    
+    return false;
+}
@@ -0,0 +1,55 @@
+#ifndef THREADPOOL_H_INCLUDED
+#define THREADPOOL_H_INCLUDED
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+public:
+    using Job = std::function<void(unsigned worker, std::size_t item)>;
+    
+    // 0 threads means one per hardware thread
+    explicit ThreadPool(unsigned threadsNum = 0);
+    ~ThreadPool();
+    
+    ThreadPool(ThreadPool const&) = delete;
+    ThreadPool& operator =(ThreadPool const&) = delete;
+    
+    unsigned size() const;
+    
+    // runs job for every item below count, returns when all are done;
+    // idle workers steal half of the items left to a busy one
+    void for_each(std::size_t count, Job const& job);
+
+private:
+    struct Queue {
+        std::mutex              mutex;
+        std::deque<std::size_t> items;
+    };
+    
+    void work(unsigned worker);
+    bool pop(unsigned worker, std::size_t& item);
+    bool steal(unsigned worker, std::size_t& item);
+    
+    std::vector<std::thread>            _threads;
+    std::vector<std::unique_ptr<Queue>> _queues;
+    
+    std::mutex               _mutex;
+    std::condition_variable  _wake;
+    std::condition_variable  _done;
+    Job const*               _job = nullptr;
+    std::size_t              _generation = 0;
+    std::atomic<std::size_t> _pending {0};
+    std::exception_ptr       _error;
+    bool                     _stop = false;
+};
+
+#endif
@@ -0,0 +1,86 @@
+#include "Trace.h"
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+Trace::Trace() : _origin(Clock::now()) {
+}
+
+std::size_t Trace::size() const {
+    std::lock_guard<std::mutex> lock {_mutex};
+    return _events.size();
+}
+
+void Trace::clear() {
+    std::lock_guard<std::mutex> lock {_mutex};
+    _events.clear();
+}
+
+void Trace::add(Event const& e) {
+    std::lock_guard<std::mutex> lock {_mutex};
+    _events.push_back(e);
+}
+
+Trace::Span::Span(Trace* trace, char const* name, int iteration)
+: _trace     {trace}
+, _name      {name}
+, _iteration {iteration}
+{
+    if(_trace) _start = Clock::now();
+}
+
+Trace::Span::~Span() {
+    if(!_trace) return;
+    
+    auto end = Clock::now();
+    _trace->add({
+        _name, 
+        _start - _trace->_origin, 
+        end - _start, 
+        std::this_thread::get_id(), 
+        _iteration
+    });
+}
+
+std::ostream& operator <<(std::ostream& os, Trace const& trace) {
+    if(!std::ostream::sentry {os}) return os;
+    
+    std::lock_guard<std::mutex> lock {trace._mutex};
+    
+    // thread ids are numbered in the order they first show up
+    std::vector<std::thread::id> threads;
+    auto tid = [&threads](std::thread::id id) {
+        auto it = std::find(threads.begin(), threads.end(), id);
+        if(it == threads.end()) {
+            threads.push_back(id);
+            return threads.size();
+        }
+        return static_cast<std::size_t>(it - threads.begin()) + 1;
+    };
+    
+    auto us = [](Trace::Clock::duration d) {
+        return std::chrono::duration<double, std::micro> {d}.count();
+    };
+    
+    auto flags = os.flags();
+    os << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+    
+    auto sep = "";
+    for(auto const& e : trace._events) {
+        os << sep
+           << "{\"name\":\"" << e.name << "\",\"ph\":\"X\""
+           << ",\"ts\":" << us(e.start)
+           << ",\"dur\":" << us(e.length)
+           << ",\"pid\":1,\"tid\":" << tid(e.thread);
+        if(e.iteration >= 0) {
+            os << ",\"args\":{\"iteration\":" << e.iteration << "}";
+        }
+        os << "}";
+        sep = ",";
+    }
+    
+    os << "],\"displayTimeUnit\":\"ns\"}";
+    os.flags(flags);
+    return os;
+}
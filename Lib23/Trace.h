@@ -0,0 +1,58 @@
+#ifndef TRACE_H_INCLUDED
+#define TRACE_H_INCLUDED
+
+#include <chrono>
+#include <iosfwd>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// timeline of named spans, written in the chrome trace-event format
+// that chrome://tracing and Perfetto load
+class Trace {
+public:
+    class Span;
+    
+    Trace();
+    
+    std::size_t size() const;
+    void clear();
+    
+    friend std::ostream& operator <<(std::ostream& os, Trace const& trace);
+
+private:
+    using Clock = std::chrono::steady_clock;
+    
+    struct Event {
+        char const*     name;
+        Clock::duration start;
+        Clock::duration length;
+        std::thread::id thread;
+        int             iteration; // -1 if the span isn't a part of one
+    };
+    
+    void add(Event const& e);
+    
+    Clock::time_point  _origin;
+    mutable std::mutex _mutex;
+    std::vector<Event> _events;
+};
+
+// records its own lifetime, does nothing without a trace;
+// names must outlive the trace, string literals are expected
+class Trace::Span {
+public:
+    Span(Trace* trace, char const* name, int iteration = -1);
+    ~Span();
+    
+    Span(Span const&) = delete;
+    Span& operator =(Span const&) = delete;
+
+private:
+    Trace*            _trace;
+    char const*       _name;
+    int               _iteration;
+    Clock::time_point _start;
+};
+
+#endif
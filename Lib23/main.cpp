@@ -1,9 +1,13 @@
 #include "Solver.h"
+#include "BatchSolver.h"
+#include "Trace.h"
 
 #include <UnitTest++/UnitTest++.h>
 
 #include <iostream>
+#include <limits>
 #include <sstream>
+#include <stdexcept>
 
 SUITE(Fraction) {
     TEST(FractionInitialization) {
@@ -65,6 +69,13 @@ SUITE(Fraction) {
         
         CHECK_THROW(a / Fraction(), std::domain_error);
         CHECK_THROW(a / 0, std::domain_error);
+        
+        auto big = std::numeric_limits<Fraction::int_t>::max();
+        CHECK_THROW(Fraction(big) + 1, std::overflow_error);
+        CHECK_THROW(Fraction(big) * 2, std::overflow_error);
+        CHECK_THROW(Fraction(1, big) + Fraction(1, big - 1), std::overflow_error);
+        CHECK_THROW(Fraction(1, big) < Fraction(1, big - 1), std::overflow_error);
+        CHECK(Fraction(big) - 1 == big - 1);
     }
     
     TEST(FractionComparisons) {
@@ -1068,6 +1079,251 @@ SUITE(Solver) {
             }
         }
     }
+    
+    TEST_FIXTURE(SolverFixture, DualFromPrimal) {
+        // the dual read off the primal tableau reaches the same optimum
+        for(int i : {0, 1, 2, 4, 5, 6, 7, 8, 10, 11, 12}) {
+            Solver primal = solver[i];
+            Solver inverted = solver[i];
+            auto dualLast = inverted.invert_to_dual().solve().back();
+            
+            auto view = primal.dual_step(primal.solve().back());
+            CHECK(view.valid());
+            CHECK(view.w == dualLast.w);
+            CHECK(view.basis.size() == dualLast.basis.size());
+        }
+        
+        auto duals = solver[4].dual_values(solver[4].solve().back());
+        CHECK((duals == std::vector<Fraction> {Fraction(11, 7), Fraction(6, 7), 0}));
+        
+        // degenerate optimum, another vertex of the dual is found
+        duals = solver[2].dual_values(solver[2].solve().back());
+        CHECK((duals == std::vector<Fraction> {0, Fraction(1, 7), Fraction(6, 7)}));
+        
+        auto s = solver[3].solve().back();
+        CHECK(solver[3].dual_values(s).empty());
+        CHECK(!solver[3].dual_step(s).valid());
+        
+        // an equality row keeps no unit column, its dual comes from the basis
+        Solver eq;
+        eq.set_goal("x1 + x2 => max");
+        eq.add_restriction("x1 + x2 == 4");
+        eq.add_restriction("x1 - x2 <= 2");
+        eq.add_restriction("x2 <= 3");
+        duals = eq.dual_values(eq.solve().back());
+        CHECK((duals == std::vector<Fraction> {1, 0, 0}));
+    }
+    
+    TEST_FIXTURE(SolverFixture, SensitivityRanges) {
+        auto sens = solver[4].sensitivity(solver[4].solve().back());
+        CHECK(sens.valid());
+        CHECK((sens.prices == std::vector<Fraction> {Fraction(11, 7), Fraction(6, 7), 0}));
+        
+        CHECK(sens.rhs.size() == 3);
+        CHECK(sens.rhs[0].lower && *sens.rhs[0].lower == -6);
+        CHECK(sens.rhs[0].upper && *sens.rhs[0].upper == 36);
+        CHECK(sens.rhs[1].lower && *sens.rhs[1].lower == 6);
+        CHECK(!sens.rhs[1].upper);
+        CHECK(!sens.rhs[2].lower);
+        CHECK(sens.rhs[2].upper && *sens.rhs[2].upper == Fraction(228, 7));
+        
+        CHECK(sens.costs.size() == 2);
+        CHECK(sens.costs[0].lower && *sens.costs[0].lower == Fraction(1, 3));
+        CHECK(!sens.costs[0].upper);
+        CHECK(sens.costs[1].lower && *sens.costs[1].lower == -2);
+        CHECK(sens.costs[1].upper && *sens.costs[1].upper == 12);
+        
+        // x1 stays out of the basis while its cost is high enough
+        sens = solver[0].sensitivity(solver[0].solve().back());
+        CHECK((sens.prices == std::vector<Fraction> {0, 0, Fraction(1, 3)}));
+        CHECK(sens.rhs[2].lower && *sens.rhs[2].lower == 0);
+        CHECK(sens.rhs[2].upper && *sens.rhs[2].upper == 12);
+        CHECK(sens.costs[0].lower && *sens.costs[0].lower == Fraction(1, 3));
+        CHECK(!sens.costs[0].upper);
+        CHECK(sens.costs[1].lower && *sens.costs[1].lower == 0);
+        CHECK(sens.costs[1].upper && *sens.costs[1].upper == 3);
+        
+        CHECK(!solver[3].sensitivity(solver[3].solve().back()).valid());
+    }
+    
+    TEST_FIXTURE(SolverFixture, BatchSolving) {
+        std::vector<Solver> models (std::begin(solver), std::end(solver));
+        
+        BatchSolver batch {3};
+        CHECK(batch.threads_num() == 3);
+        
+        auto lasts = batch.solve(models);
+        CHECK(lasts.size() == models.size());
+        for(auto i = 0u; i < models.size(); ++i) {
+            auto last = solver[i].solve().back();
+            CHECK(lasts[i].valid() == last.valid());
+            CHECK(lasts[i].w == last.w);
+            CHECK(lasts[i].basis == last.basis);
+        }
+        
+        lasts = batch.solve(std::vector<BatchSolver::Model> {
+            {"x1 + x2 => min", {"2x1 + 4x2 <= 16", "-4x1 + 2x2 <= 8", "1x1 + 3x2 >= 9"}},
+            {"not a goal", {"x1 <= 1"}},
+            {"4x1 + x2 => max", {"2x1 - x2 <= 12", "x1 + 3x2 <= 18", "2x1 + 5x2 >= 10"}},
+            {"x1 + x2 => min", {"not a restriction"}}
+        });
+        CHECK(lasts.size() == 4);
+        CHECK(lasts[0].valid() && lasts[0].w == 3);
+        CHECK(!lasts[1].valid());
+        CHECK(lasts[2].valid() && lasts[2].w == Fraction(240, 7));
+        CHECK(!lasts[3].valid());
+        
+        lasts = batch.solve(std::vector<BatchSolver::Model> {
+            {"x1 + x2 => max", {"3000000019x1 + 3000000021x2 <= 3000000017", "3000000023x1 + 2999999999x2 <= 3000000029"}},
+            {"x1 + x2 => min", {"2x1 + 4x2 <= 16", "-4x1 + 2x2 <= 8", "1x1 + 3x2 >= 9"}}
+        });
+        CHECK(lasts.size() == 2);
+        CHECK(!lasts[0].valid() && lasts[0].status == Solver::Status::overflow);
+        CHECK(lasts[1].valid() && lasts[1].w == 3);
+        
+        CHECK(batch.solve(std::vector<Solver> {}).empty());
+        
+        Solver::Stats shared;
+        Solver::Options options;
+        options.stats = &shared;
+        std::vector<Solver::Stats> stats;
+        batch.solve(models, options, &stats);
+        CHECK(shared.iterations.empty());
+        CHECK(stats.size() == models.size());
+        for(auto i = 0u; i < models.size(); ++i) {
+            Solver::Stats own;
+            Solver::Options single;
+            single.stats = &own;
+            Solver(solver[i]).solve(single);
+            CHECK(stats[i].iterations.size() == own.iterations.size());
+        }
+    }
+    
+    TEST_FIXTURE(SolverFixture, SolveLimits) {
+        using Status = Solver::Status;
+        
+        CHECK(Solver(solver[0]).solve().back().status == Status::optimal);
+        CHECK(Solver(solver[3]).solve().back().status == Status::infeasible);
+        CHECK(Solver(solver[9]).solve().back().status == Status::cycled);
+        
+        Solver unbounded;
+        unbounded.set_goal("x1 + x2 => max");
+        unbounded.add_restriction("x1 - x2 <= 2");
+        CHECK(unbounded.solve().back().status == Status::unbounded);
+        
+        Solver::Options options;
+        options.maxIterations = 1;
+        auto steps = Solver(solver[9]).solve(options);
+        CHECK(steps.size() == 2);
+        CHECK(steps.back().status == Status::limit);
+        
+        options = Solver::Options {};
+        options.deadline = std::chrono::steady_clock::now();
+        steps = Solver(solver[0]).solve(options);
+        CHECK(steps.size() == 1);
+        CHECK(steps.back().status == Status::limit);
+        
+        std::atomic<bool> cancel {true};
+        options = Solver::Options {};
+        options.cancel = &cancel;
+        steps = Solver(solver[0]).solve(options);
+        CHECK(steps.size() == 1);
+        CHECK(steps.back().status == Status::cancelled);
+        
+        Solver huge;
+        huge.set_goal("x1 + x2 => max");
+        huge.add_restriction("3000000019x1 + 3000000021x2 <= 3000000017");
+        huge.add_restriction("3000000023x1 + 2999999999x2 <= 3000000029");
+        CHECK_THROW(Solver(huge).solve(), std::overflow_error);
+    }
+    
+    TEST_FIXTURE(SolverFixture, LazySteps) {
+        for(auto const& model : solver) {
+            auto steps = Solver(model).solve();
+            
+            Solver lazy = model;
+            auto i = 0u;
+            for(auto const& s : lazy.solve_steps()) {
+                CHECK(i < steps.size());
+                if(i == steps.size()) break;
+                
+                CHECK(s == steps[i]);
+                CHECK(s.status == steps[i].status);
+                CHECK(s.w == steps[i].w);
+                CHECK(s.basis == steps[i].basis);
+                CHECK(s.valid() == steps[i].valid());
+                ++i;
+            }
+            CHECK(i == steps.size());
+        }
+        
+        // stopping early leaves nothing half done
+        auto steps = solver[0].solve_steps();
+        CHECK(steps.next());
+        CHECK(steps.current().status == Solver::Status::none);
+        CHECK(steps.next());
+        CHECK(steps.current().status == Solver::Status::optimal);
+        CHECK(!steps.next());
+        CHECK(steps.begin() == steps.end());
+    }
+    
+    TEST_FIXTURE(SolverFixture, SolveStats) {
+        Solver::Stats stats;
+        Solver::Options options;
+        options.stats = &stats;
+        
+        auto steps = Solver(solver[0]).solve(options);
+        CHECK(stats.iterations.size() == steps.size());
+        CHECK(stats.stepCopies == 2 * steps.size() - 1);
+        CHECK(stats.gcdCalls > 0);
+        CHECK(stats.iterations.front().pivot.count() == 0);
+        CHECK(stats.iterations.back().pivot.count() > 0);
+        CHECK(stats.degeneratePivots == 0);
+        CHECK(stats.maxNumBits == 5);
+        CHECK(stats.maxDenBits == 2);
+        
+        unsigned long long gcdCalls = 0;
+        for(auto const& it : stats.iterations) {
+            gcdCalls += it.gcdCalls;
+        }
+        CHECK(gcdCalls == stats.gcdCalls);
+        
+        std::stringstream ss;
+        write_json(ss, stats);
+        CHECK(ss.str().find("{\"gcd_calls\":" + std::to_string(stats.gcdCalls)) == 0);
+        CHECK(ss.str().find("\"degenerate\":false}]}") != std::string::npos);
+        
+        // stats start over with each solve
+        Solver(solver[1]).solve(options);
+        auto again = stats.iterations.size();
+        Solver(solver[1]).solve(options);
+        CHECK(stats.iterations.size() == again);
+    }
+    
+    TEST_FIXTURE(SolverFixture, SolveTrace) {
+        Trace trace;
+        Solver::Options options;
+        options.trace = &trace;
+        
+        auto steps = Solver(solver[0]).solve(options);
+        // solve, 2 setup spans, setup, and per step: iteration, pricing, 
+        // cycle check, column choice; the step before a pivot adds
+        // the ratio test, the one after it the pivot itself
+        CHECK(trace.size() == 4 + 4 * steps.size() + 2 * (steps.size() - 1));
+        
+        std::stringstream ss;
+        ss << trace;
+        auto json = ss.str();
+        CHECK(json.find("{\"traceEvents\":[") == 0);
+        CHECK(json.find("\"name\":\"append_artificial\",\"ph\":\"X\"") != std::string::npos);
+        CHECK(json.find("\"args\":{\"iteration\":1}") != std::string::npos);
+        CHECK(json.rfind("],\"displayTimeUnit\":\"ns\"}") != std::string::npos);
+        
+        trace.clear();
+        CHECK(trace.size() == 0);
+        Solver(solver[0]).solve();
+        CHECK(trace.size() == 0);
+    }
 }
 
 int main(int, char*[]) {
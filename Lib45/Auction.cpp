@@ -0,0 +1,297 @@
+#include "Auction.h"
+#include <Trace.h>
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdlib>
+#include <numeric>
+
+using std::vector;
+
+static constexpr long long NONE = LLONG_MAX;
+
+Auction::Auction(unsigned threadsNum) : _pool(threadsNum) {
+}
+
+unsigned Auction::threads_num() const {
+    return _pool.size();
+}
+
+unsigned long Auction::rounds() const {
+    return _rounds;
+}
+
+unsigned long Auction::bids() const {
+    return _bids;
+}
+
+inline namespace helpers {
+    // some of a sink's demand, taken by a source at a price
+    struct Holding {
+        int       source;
+        long long amount;
+        long long price;
+    };
+    
+    struct Bid {
+        int       source;
+        int       sink;
+        long long amount;
+        long long price;
+    };
+    
+    // the demand nobody holds yet goes at the base price, the held
+    // is kept by price, cheapest first
+    struct Sink {
+        long long       base = 0;
+        long long       free = 0;
+        vector<Holding> held;
+        
+        // what the bidders see: the cheapest price, how much goes at it
+        // and the next price up, NONE if there's no other; a sink with no
+        // demand has no price at all
+        long long price = 0;
+        long long amount = 0;
+        long long next = NONE;
+        
+        void look();
+        void settle(Bid const* first, Bid const* last, vector<std::atomic<long long>>& left);
+    };
+    
+    void
+    Sink::look() {
+        if(free > 0) {
+            price = base;
+            amount = free;
+            next = held.empty() ? NONE : held.front().price;
+            return;
+        }
+        
+        if(held.empty()) {
+            price = NONE;
+            amount = 0;
+            next = NONE;
+            return;
+        }
+        
+        price = held.front().price;
+        amount = 0;
+        next = NONE;
+        for(auto const& h : held) {
+            if(h.price != price) {
+                next = h.price;
+                break;
+            }
+            amount += h.amount;
+        }
+    }
+    
+    // the highest bids go first and take the cheapest copies they're
+    // over, the free ones first; the outbid holders and the bidders that
+    // found nothing cheap enough get their quantity back in left
+    void
+    Sink::settle(Bid const* first, Bid const* last, vector<std::atomic<long long>>& left) {
+        vector<Bid> bids (first, last);
+        std::sort(bids.begin(), bids.end(), [](Bid const& a, Bid const& b) {
+            return a.price > b.price || (a.price == b.price && a.source < b.source);
+        });
+        
+        vector<Holding> won;
+        auto cheapest = held.begin();
+        for(auto const& bid : bids) {
+            auto want = bid.amount;
+            
+            auto take = std::min(want, base < bid.price ? free : 0);
+            free -= take;
+            want -= take;
+            auto got = take;
+            
+            while(want > 0 && cheapest != held.end() && cheapest->price < bid.price) {
+                take = std::min(want, cheapest->amount);
+                cheapest->amount -= take;
+                left[cheapest->source] += take;
+                want -= take;
+                got += take;
+                if(cheapest->amount == 0) ++cheapest;
+            }
+            
+            if(got > 0) won.push_back({bid.source, got, bid.price});
+            if(want > 0) left[bid.source] += want;
+        }
+        
+        held.erase(std::remove_if(held.begin(), held.end(), [](Holding const& h) {
+            return h.amount == 0;
+        }), held.end());
+        held.insert(held.end(), won.begin(), won.end());
+        std::stable_sort(held.begin(), held.end(), [](Holding const& a, Holding const& b) {
+            return a.price < b.price;
+        });
+        
+        look();
+    }
+    
+    // the cheapest copies for the source and the price to take them at,
+    // which is what it would lose going elsewhere plus eps; with fewer
+    // wanted than the sink has at its price the rest are as good a
+    // choice, so it only goes eps over them
+    Bid
+    make_bid(
+        long long const* costs,
+        vector<Sink> const& sinks,
+        int source,
+        long long want,
+        long long eps
+    ) {
+        auto best = -1;
+        long long bestTotal = NONE;
+        long long secondTotal = NONE;
+        for(auto j = 0u; j < sinks.size(); ++j) {
+            if(sinks[j].price == NONE) continue;
+            
+            auto total = costs[j] + sinks[j].price;
+            if(best < 0 || total < bestTotal) {
+                secondTotal = bestTotal;
+                bestTotal = total;
+                best = j;
+            }
+            else if(total < secondTotal) {
+                secondTotal = total;
+            }
+        }
+        
+        auto const& sink = sinks[best];
+        if(want < sink.amount) return {source, best, want, sink.price + eps};
+        
+        if(sink.next != NONE) {
+            secondTotal = std::min(secondTotal, costs[best] + sink.next);
+        }
+        auto price = secondTotal == NONE ? sink.price + eps : secondTotal - costs[best] + eps;
+        return {source, best, sink.amount, price};
+    }
+}
+
+Matrix2D<long long> Auction::solve(
+    Matrix2D<long long> const& costs,
+    vector<long long> const& prods,
+    vector<long long> const& consums,
+    Trace* trace
+) {
+    Trace::Span span {trace, "auction"};
+    
+    _rounds = 0;
+    _bids = 0;
+    
+    int rowsNum = prods.size();
+    int colsNum = consums.size();
+    if(costs.rows() != prods.size() || costs.cols() != consums.size() || costs.empty()) return {};
+    if(std::accumulate(prods.begin(), prods.end(), 0ll) != std::accumulate(consums.begin(), consums.end(), 0ll)) {
+        return {};
+    }
+    
+    // a cycle of the plan has fewer cells than scale, so it can't lose
+    // a whole unit of cost to eps = 1 in every cell
+    long long scale = rowsNum + colsNum + 1;
+    Matrix2D<long long> scaled (rowsNum, colsNum);
+    long long most = 0;
+    for(int i = 0; i < rowsNum; ++i) {
+        for(int j = 0; j < colsNum; ++j) {
+            scaled[i][j] = costs[i][j] * scale;
+            most = std::max(most, std::abs(scaled[i][j]));
+        }
+    }
+    
+    // rounds late in a phase have a few bids, not worth waking the pool
+    auto spread = [this](std::size_t count, ThreadPool::Job const& job) {
+        if(count < 64 || _pool.size() == 1) {
+            for(auto k = 0u; k < count; ++k) {
+                job(0, k);
+            }
+        }
+        else {
+            _pool.for_each(count, job);
+        }
+    };
+    
+    vector<Sink> sinks (colsNum);
+    vector<std::atomic<long long>> left (rowsNum);
+    vector<int> active;
+    vector<Bid> bids;
+    vector<Bid> bySink;
+    vector<int> starts (colsNum + 1);
+    vector<int> bidden;
+    
+    // starting higher only has the first phases spread the bids the same
+    // way again, dropping eps faster has the last ones fix more of the plan
+    auto phase = 0;
+    for(auto eps = std::max(1ll, most / 20); ; eps = std::max(1ll, eps / 5)) {
+        Trace::Span phaseSpan {trace, "phase", ++phase};
+        
+        // the prices are kept, the plan starts over
+        for(int j = 0; j < colsNum; ++j) {
+            auto& s = sinks[j];
+            s.base = s.free > 0 || s.held.empty() ? s.base : s.held.front().price;
+            s.free = consums[j];
+            s.held.clear();
+            s.look();
+        }
+        for(int i = 0; i < rowsNum; ++i) {
+            left[i] = prods[i];
+        }
+        
+        while(true) {
+            active.clear();
+            for(int i = 0; i < rowsNum; ++i) {
+                if(left[i] > 0) active.push_back(i);
+            }
+            if(active.empty()) break;
+            
+            ++_rounds;
+            _bids += active.size();
+            
+            bids.resize(active.size());
+            {
+                Trace::Span span {trace, "bids"};
+                spread(active.size(), [&](unsigned, std::size_t k) {
+                    auto i = active[k];
+                    bids[k] = make_bid(scaled[i].begin(), sinks, i, left[i], eps);
+                    left[i] -= bids[k].amount;
+                });
+            }
+            
+            // the bids are grouped by sink in the order they were made
+            std::fill(starts.begin(), starts.end(), 0);
+            for(auto const& b : bids) {
+                ++starts[b.sink + 1];
+            }
+            std::partial_sum(starts.begin(), starts.end(), starts.begin());
+            bySink.resize(bids.size());
+            bidden.clear();
+            {
+                auto fill = starts;
+                for(auto const& b : bids) {
+                    if(fill[b.sink] == starts[b.sink]) bidden.push_back(b.sink);
+                    bySink[fill[b.sink]++] = b;
+                }
+            }
+            
+            {
+                Trace::Span span {trace, "settle"};
+                spread(bidden.size(), [&](unsigned, std::size_t k) {
+                    auto j = bidden[k];
+                    sinks[j].settle(bySink.data() + starts[j], bySink.data() + starts[j + 1], left);
+                });
+            }
+        }
+        
+        if(eps == 1) break;
+    }
+    
+    Matrix2D<long long> ret (rowsNum, colsNum, 0);
+    for(int j = 0; j < colsNum; ++j) {
+        for(auto const& h : sinks[j].held) {
+            ret[h.source][j] += h.amount;
+        }
+    }
+    return ret;
+}
@@ -0,0 +1,44 @@
+#ifndef AUCTION_H_INCLUDED
+#define AUCTION_H_INCLUDED
+
+#include "Matrix2D.h"
+
+#include <ThreadPool.h>
+#include <vector>
+
+class Trace;
+
+// the transportation problem by the auction algorithm: a source with
+// quantity left bids for the cheapest copies of some sink's demand,
+// outbidding their holders by what it would lose going elsewhere plus
+// eps, and the outbid get their quantity back to bid again.
+// eps is scaled down phase by phase; with the costs multiplied by more
+// than the rows and columns there are, the last phase at eps = 1 leaves
+// an optimal plan.
+// Every round the sources bid in parallel against the prices of the
+// previous one, then every sink settles its own bids, so a price is
+// only ever written by one worker and no locks are taken
+class Auction {
+public:
+    // 0 threads means one per hardware thread
+    explicit Auction(unsigned threadsNum = 0);
+    
+    // the quantities have to balance, the plan is empty if they don't
+    Matrix2D<long long> solve(
+        Matrix2D<long long> const& costs,
+        std::vector<long long> const& prods,
+        std::vector<long long> const& consums,
+        Trace* trace = nullptr
+    );
+    
+    unsigned threads_num() const;
+    unsigned long rounds() const; // of the last solve, over all phases
+    unsigned long bids() const;
+
+private:
+    ThreadPool    _pool;
+    unsigned long _rounds = 0;
+    unsigned long _bids = 0;
+};
+
+#endif
@@ -1,43 +1,46 @@
 #include "BalanceMatrix.h"
+#include "Kernels.h"
+#include "Auction.h"
+#include "MinCostFlow.h"
+#include <Fraction.h>
+#include <Trace.h>
 
 #include <iostream>
 #include <iomanip>
 #include <initializer_list>
 #include <cassert>
+#include <cmath>
 #include <vector>
 #include <algorithm>
 #include <numeric>
+#include <queue>
+#include <type_traits>
 #include <boost/optional.hpp>
+#include <limits>
 
 using std::pair;
 using std::tuple;
 using std::vector;
 using boost::optional;
-using OptInt = optional<int>;
 
-template <typename T>
-using Vector2D = vector<vector<T>>;
-
-using Line = vector<int>;
-using Matrix = Vector2D<int>;
 using Cell = pair<int, int>;
 using Link = pair<int, int>;
+using Eps = Matrix2D<char>;
 
-static constexpr int EPS = -1;
-
-std::ostream& operator <<(std::ostream& os, BalanceMatrix const& m) {
+template <typename Cost, typename Qty>
+std::ostream& operator <<(std::ostream& os, BasicBalanceMatrix<Cost, Qty> const& m) {
     std::ostream::sentry osOk {os};
     if(!osOk) return os;
     
     os << "[Balance:\n";
-    for(auto r = 0u; r < m._costs.size(); ++r) {
-        for(int c : m._costs[r]) {
+    for(auto r = 0u; r < m._costs.rows(); ++r) {
+        for(auto const& c : m._costs[r]) {
             os << std::setw(4) << c;
         }
         os << "|" << std::setw(4) << m._prods[r] << '\n';
     }
     if(!m._consums.empty()) {
-        for(int c : m._consums) {
+        for(auto const& c : m._consums) {
             os << std::setw(4) << c;
         }
         os << "\n]";
@@ -46,25 +49,32 @@ std::ostream& operator <<(std::ostream& os, BalanceMatrix const& m) {
     return os;
 }
 
-void print_vec2d(std::ostream& os, std::vector<std::vector<int>> const& vec2d, bool eps_is_minus_one) {
+template <typename T>
+void print_vec2d(std::ostream& os, Matrix2D<T> const& vec2d) {
+    print_vec2d(os, vec2d, Eps (vec2d.rows(), vec2d.cols(), false));
+}
+
+template <typename T>
+void print_vec2d(std::ostream& os, Matrix2D<T> const& vec2d, Eps const& eps) {
     std::ostream::sentry osOk {os};
     if(!osOk) return;
     
     os << "[";
-    for(auto const& row : vec2d) {
+    for(auto i = 0u; i < vec2d.rows(); ++i) {
         os << "\n";
-        for(auto const& item : row) {
-            if(eps_is_minus_one && item <= EPS) os << std::setw(3) << std::abs(item) << 'E';
-            else os << std::setw(4) << item;
+        for(auto j = 0u; j < vec2d.cols(); ++j) {
+            if(eps[i][j]) os << std::setw(3) << vec2d[i][j] << 'E';
+            else os << std::setw(4) << vec2d[i][j];
         }
     }
     os << "\n]";
 }
 
-bool BalanceMatrix::set(std::initializer_list<std::vector<int>> const& rows) {
+template <typename Cost, typename Qty>
+bool BasicBalanceMatrix<Cost, Qty>::set(std::initializer_list<std::vector<Cost>> const& rows) {
     if(rows.size() < 2) return false;
     
-    vector<vector<int>> rowsCopy;
+    vector<vector<Cost>> rowsCopy;
     for(auto const& row : rows) {
         auto rowCopy = row;
         rowsCopy.push_back(rowCopy);
@@ -73,68 +83,111 @@ bool BalanceMatrix::set(std::initializer_list<std::vector<int>> const& rows) {
     return set(rowsCopy);
 }
 
-bool BalanceMatrix::set(vector<vector<int>> const& rows) {
+template <typename Cost, typename Qty>
+bool BasicBalanceMatrix<Cost, Qty>::set(vector<vector<Cost>> const& rows) {
     if(rows.size() < 2) return false;
     
-    Matrix costs;
-    Line prods;
-    Line consums;
+    vector<Qty> prods;
+    vector<Qty> consums (rows.back().begin(), rows.back().end());
     
+    // every row of costs ends with the production
+    auto length = consums.size();
+    if(length == 0) return false;
     for(auto r = rows.begin(); r != rows.end() - 1; ++r) {
-        costs.push_back(*r);
-        costs.back().pop_back();
-        prods.push_back(r->back());
+        if(r->size() != length + 1) return false;
+        prods.push_back(Qty(r->back()));
     }
-    consums = *(rows.end() - 1);
     
-    auto length = costs.front().size();
-    if(prods.size() != costs.size()) return false;
-    if(consums.size() != length) return false;
-    for(auto i = 1u; i < costs.size(); ++i) {
-        if(costs[i].size() != length) return false;
+    Matrix2D<Cost> costs (prods.size(), length);
+    for(auto i = 0u; i < prods.size(); ++i) {
+        std::copy(rows[i].begin(), rows[i].end() - 1, costs[i].begin());
     }
     
+    return set(costs, prods, consums);
+}
+
+template <typename Cost, typename Qty>
+bool BasicBalanceMatrix<Cost, Qty>::set(Matrix2D<Cost> const& costs, vector<Qty> const& prods, vector<Qty> const& consums) {
+    if(costs.empty() || costs.rows() != prods.size() || costs.cols() != consums.size()) return false;
+    
     _costs = costs;
     _prods = prods;
     _consums = consums;
+    _caps = Matrix2D<Qty> {};
+    _arcs.clear();
     
     return true;
 }
 
-static void flatten(Matrix& costs, vector<int>& prods, vector<int>& consums) {
-    auto prodsSum = std::accumulate(prods.begin(), prods.end(), 0);
-    auto consumsSum = std::accumulate(consums.begin(), consums.end(), 0);
+template <typename Cost, typename Qty>
+bool BasicBalanceMatrix<Cost, Qty>::set(vector<Arc> const& arcs, vector<Qty> const& prods, vector<Qty> const& consums) {
+    if(arcs.empty() || prods.empty() || consums.empty()) return false;
+    for(auto const& a : arcs) {
+        if(a.source < 0 || a.source >= int(prods.size())) return false;
+        if(a.sink < 0 || a.sink >= int(consums.size())) return false;
+    }
+    
+    _costs = Matrix2D<Cost> {};
+    _prods = prods;
+    _consums = consums;
+    _caps = Matrix2D<Qty> {};
+    _arcs = arcs;
+    
+    return true;
+}
+
+template <typename Cost, typename Qty>
+bool BasicBalanceMatrix<Cost, Qty>::set_capacities(Matrix2D<Qty> const& caps) {
+    if(!caps.empty() && (caps.rows() != _costs.rows() || caps.cols() != _costs.cols())) return false;
+    for(auto i = 0u; i < caps.rows(); ++i) {
+        for(auto const& cap : caps[i]) {
+            if(cap < Qty {}) return false;
+        }
+    }
+    
+    _caps = caps;
+    return true;
+}
+
+template <typename Cost, typename Qty>
+static void flatten(Matrix2D<Cost>& costs, vector<Qty>& prods, vector<Qty>& consums) {
+    auto prodsSum = std::accumulate(prods.begin(), prods.end(), Qty {});
+    auto consumsSum = std::accumulate(consums.begin(), consums.end(), Qty {});
     
     if(consumsSum > prodsSum) {
         prods.push_back(consumsSum - prodsSum);
-        
-        Line newRow (consums.size());
-        costs.push_back(newRow);
+        costs.resize(costs.rows() + 1, costs.cols(), Cost {});
     }
     else if(prodsSum > consumsSum) {
         consums.push_back(prodsSum - consumsSum);
-        
-        for(auto& r : costs) {
-            r.push_back(0);
-        }
+        costs.resize(costs.rows(), costs.cols() + 1, Cost {});
     }
 }
 
-Matrix BalanceMatrix::get_key0_by_nw_method(
-    Line* outProds,
-    Line* outConsums,
-    Matrix* outCosts
+template <typename Cost, typename Qty>
+Matrix2D<Qty> BasicBalanceMatrix<Cost, Qty>::get_key0_by_nw_method(
+    vector<Qty>* outProds,
+    vector<Qty>* outConsums,
+    Matrix2D<Cost>* outCosts,
+    Trace* trace
 ) const {
+    if(_costs.empty()) return {};
+    
+    Trace::Span span {trace, "initial_plan"};
+    
     auto costs   = _costs;
     auto prods   = _prods;
     auto consums = _consums;
     
-    flatten(costs, prods, consums);
+    {
+        Trace::Span span {trace, "flatten"};
+        flatten(costs, prods, consums);
+    }
     
     auto prodsNum    = prods.size();
     auto consumsNum  = consums.size();
     
-    Matrix ret (prodsNum, Line(consumsNum, 0));
+    Matrix2D<Qty> ret (prodsNum, consumsNum, Qty {});
     
     for(auto i = 0u; i < prodsNum; ++i) {
         for(auto j = 0u; j < consumsNum; ++j) {
@@ -158,56 +211,238 @@ Matrix BalanceMatrix::get_key0_by_nw_method(
     return ret;
 }
 
-static vector<Cell> enumerate_by_min(Matrix const& costs) {
-    vector<Cell> ret;
+// the order the least cost method takes the cells in: by cost, then by
+// i + j, then by row; zero costs go last, they're mostly the flattened
+// dummy line
+template <typename Cost>
+static bool cheaper(Matrix2D<Cost> const& costs, int ai, int aj, int bi, int bj) {
+    auto const& a = costs[ai][aj];
+    auto const& b = costs[bi][bj];
+    
+    auto aZero = a == Cost {};
+    auto bZero = b == Cost {};
+    if(aZero != bZero) return bZero;
+    if(!(a == b)) return a < b;
+    if(ai + aj != bi + bj) return ai + aj < bi + bj;
+    return ai < bi;
+}
+
+template <typename Cost, typename Qty>
+Matrix2D<Qty> BasicBalanceMatrix<Cost, Qty>::get_key0_by_min_method(
+    vector<Qty>* outProds,
+    vector<Qty>* outConsums,
+    Matrix2D<Cost>* outCosts,
+    Trace* trace
+) const {
+    if(_costs.empty()) return {};
     
-    for(auto i = 0u; i < costs.size(); ++i) {
-        for(auto j = 0u; j < costs[0].size(); ++j) {
-            ret.emplace_back(i, j);
-        }
+    Trace::Span span {trace, "initial_plan"};
+    
+    auto costs   = _costs;
+    auto prods   = _prods;
+    auto consums = _consums;
+    
+    {
+        Trace::Span span {trace, "flatten"};
+        flatten(costs, prods, consums);
     }
     
-    std::sort(ret.begin(), ret.end(), [&ret, &costs](Cell const& a, Cell const& b){
-        if(costs[a.first][a.second] == costs[b.first][b.second]) {
-            return a.first + a.second < b.first + b.second;
-        }
-        else {
-            return costs[a.first][a.second] < costs[b.first][b.second];
-        }
-    });
+    int prodsNum    = prods.size();
+    int consumsNum  = consums.size();
+    
+    Matrix2D<Qty> ret (prodsNum, consumsNum, Qty {});
+    
+    // every row keeps its columns in a heap and the rows are in a heap by
+    // their cheapest cell, so the cells come in order without sorting them
+    // all; cells of used up columns are dropped as they come up, used up
+    // rows leave, and it's over once all the rows or the columns are
+    vector<int> cols (prodsNum * consumsNum);
+    vector<int> colsLeft (prodsNum, consumsNum);
+    auto rowLater = [&costs](int i) {
+        return [&costs, i](int a, int b) { return cheaper(costs, i, b, i, a); };
+    };
+    auto headLater = [&costs, &cols, consumsNum](int a, int b) {
+        return cheaper(costs, b, cols[b * consumsNum], a, cols[a * consumsNum]);
+    };
+    
+    vector<int> heads;
+    for(int i = 0; i < prodsNum; ++i) {
+        auto first = cols.begin() + i * consumsNum;
+        std::iota(first, first + consumsNum, 0);
+        std::make_heap(first, first + consumsNum, rowLater(i));
+        if(prods[i] != Qty {}) heads.push_back(i);
+    }
+    std::make_heap(heads.begin(), heads.end(), headLater);
     
-    auto firstNotZero = std::find_if(ret.begin(), ret.end(),
-    [&ret, &costs](Cell const& a){
-        return costs[a.first][a.second] > 0;
+    auto openCols = std::count_if(consums.begin(), consums.end(), [](Qty const& c) {
+        return c != Qty {};
     });
+    while(!heads.empty() && openCols > 0) {
+        std::pop_heap(heads.begin(), heads.end(), headLater);
+        auto i = heads.back();
+        
+        auto first = cols.begin() + i * consumsNum;
+        auto j = *first;
+        std::pop_heap(first, first + colsLeft[i]--, rowLater(i));
+        
+        if(consums[j] != Qty {}) {
+            auto x = std::min(prods[i], consums[j]);
+            prods[i] -= x;
+            consums[j] -= x;
+            ret[i][j] = x;
+            if(consums[j] == Qty {}) --openCols;
+        }
+        
+        if(prods[i] == Qty {} || colsLeft[i] == 0) heads.pop_back();
+        else std::push_heap(heads.begin(), heads.end(), headLater);
+    }
     
-    std::rotate(ret.begin(), firstNotZero, ret.end());
+    if(outProds) {
+        *outProds = prods;
+    }
+    if(outConsums) {
+        *outConsums = consums;
+    }
+    if(outCosts) {
+        *outCosts = costs;
+    }
     
     return ret;
 }
 
-Matrix BalanceMatrix::get_key0_by_min_method(
-    Line* outProds,
-    Line* outConsums,
-    Matrix* outCosts
+// a row or a column with the lines of the other side sorted by cost
+struct VogelLine {
+    vector<int> order;
+    unsigned    pos = 0; // lines before it in order are used up
+    bool        active = true;
+    int         version = 0;
+    int         first = -1; // the two cheapest active cells, -1 if none
+    int         second = -1;
+};
+
+// inactive lines in front of the second cheapest are dropped for good,
+// so each one is passed over once
+static void find_cheapest(VogelLine& line, vector<VogelLine> const& others) {
+    auto& order = line.order;
+    while(line.pos < order.size() && !others[order[line.pos]].active) ++line.pos;
+    
+    line.first = line.pos < order.size() ? order[line.pos] : -1;
+    line.second = -1;
+    if(line.first < 0) return;
+    
+    auto k = line.pos + 1;
+    while(k < order.size() && !others[order[k]].active) ++k;
+    if(k < order.size()) {
+        line.second = order[k];
+        order[k - 1] = line.first;
+        line.pos = k - 1;
+    }
+}
+
+template <typename Cost, typename Qty>
+Matrix2D<Qty> BasicBalanceMatrix<Cost, Qty>::get_key0_by_vogel_method(
+    vector<Qty>* outProds,
+    vector<Qty>* outConsums,
+    Matrix2D<Cost>* outCosts,
+    Trace* trace
 ) const {
+    if(_costs.empty()) return {};
+    
+    Trace::Span span {trace, "initial_plan"};
+    
     auto costs   = _costs;
     auto prods   = _prods;
     auto consums = _consums;
     
-    flatten(costs, prods, consums);
+    {
+        Trace::Span span {trace, "flatten"};
+        flatten(costs, prods, consums);
+    }
     
-    auto prodsNum    = prods.size();
-    auto consumsNum  = consums.size();
+    int prodsNum    = prods.size();
+    int consumsNum  = consums.size();
     
-    Matrix ret (prodsNum, vector<int>(consumsNum, 0));
-    auto indices = enumerate_by_min(costs);
+    Matrix2D<Qty> ret (prodsNum, consumsNum, Qty {});
     
-    for(auto const& c : indices) {
-        auto x = std::min(prods[c.first], consums[c.second]);
-        prods[c.first] -= x;
-        consums[c.second] -= x;
-        ret[c.first][c.second] = x;
+    vector<VogelLine> rows (prodsNum);
+    vector<VogelLine> cols (consumsNum);
+    for(int i = 0; i < prodsNum; ++i) {
+        auto& order = rows[i].order;
+        order.resize(consumsNum);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+            return costs[i][a] < costs[i][b];
+        });
+    }
+    for(int j = 0; j < consumsNum; ++j) {
+        auto& order = cols[j].order;
+        order.resize(prodsNum);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+            return costs[a][j] < costs[b][j];
+        });
+    }
+    
+    // lines are numbered rows first, a line goes out of the queue by its
+    // version growing, the entry with the old one is skipped then
+    struct Penalty {
+        Cost penalty;
+        Cost minCost;
+        int line;
+        int version;
+        
+        bool operator <(Penalty const& o) const {
+            if(penalty != o.penalty) return penalty < o.penalty;
+            if(minCost != o.minCost) return minCost > o.minCost;
+            return line > o.line;
+        }
+    };
+    std::priority_queue<Penalty> queue;
+    
+    auto cost = [&](int line, int other) {
+        return line < prodsNum ? costs[line][other] : costs[other][line - prodsNum];
+    };
+    auto update = [&](int line) {
+        auto& l = line < prodsNum ? rows[line] : cols[line - prodsNum];
+        find_cheapest(l, line < prodsNum ? cols : rows);
+        ++l.version;
+        if(l.first < 0) return;
+        
+        auto minCost = cost(line, l.first);
+        auto penalty = l.second < 0 ? minCost : cost(line, l.second) - minCost;
+        queue.push({penalty, minCost, line, l.version});
+    };
+    
+    for(int line = 0; line < prodsNum + consumsNum; ++line) {
+        update(line);
+    }
+    
+    // lines that had the used up one among their two cheapest get new penalties
+    auto deactivate = [&](VogelLine& used, int index, vector<VogelLine>& others, int othersBase) {
+        used.active = false;
+        for(auto k = 0u; k < others.size(); ++k) {
+            auto& o = others[k];
+            if(o.active && (o.first == index || o.second == index)) update(othersBase + k);
+        }
+    };
+    
+    while(!queue.empty()) {
+        auto top = queue.top();
+        queue.pop();
+        
+        auto& l = top.line < prodsNum ? rows[top.line] : cols[top.line - prodsNum];
+        if(!l.active || l.version != top.version) continue;
+        
+        auto i = top.line < prodsNum ? top.line : l.first;
+        auto j = top.line < prodsNum ? l.first : top.line - prodsNum;
+        
+        auto x = std::min(prods[i], consums[j]);
+        prods[i] -= x;
+        consums[j] -= x;
+        ret[i][j] = x;
+        
+        if(prods[i] == Qty {}) deactivate(rows[i], i, cols, prodsNum);
+        if(consums[j] == Qty {}) deactivate(cols[j], j, rows, 0);
     }
     
     if(outProds) {
@@ -223,69 +458,294 @@ Matrix BalanceMatrix::get_key0_by_min_method(
     return ret;
 }
 
-static vector<Link> 
-form_links(Matrix const& x) {
-    vector<Link> ret;
+// basic cells as a graph whose nodes are the rows and the columns
+struct BasisTree {
+    BasisTree(std::size_t rows, std::size_t cols);
+    
+    template <typename Qty>
+    BasisTree(Matrix2D<Qty> const& x, Eps const& eps);
+    
+    void link(int i, int j);
+    void unlink(int i, int j);
+    
+    // cells on the way from the row to the column, the last one is in the row
+    vector<Cell> path(int row, int col) const;
     
-    for(auto i = 0u; i < x.size(); ++i) { // consums
-        for(auto j = 0u; j < x[0].size(); ++j) { // prods
-            if(x[i][j] != 0) {
-                ret.emplace_back(i, j);
+    vector<vector<int>> rowLinks; // columns linked to each row
+    vector<vector<int>> colLinks; // rows linked to each column
+};
+
+BasisTree::BasisTree(std::size_t rows, std::size_t cols)
+: rowLinks (rows)
+, colLinks (cols)
+{}
+
+template <typename Qty>
+BasisTree::BasisTree(Matrix2D<Qty> const& x, Eps const& eps)
+: BasisTree(x.rows(), x.cols())
+{
+    for(auto i = 0u; i < x.rows(); ++i) {
+        for(auto j = 0u; j < x.cols(); ++j) {
+            if(x[i][j] != Qty {} || eps[i][j]) link(i, j);
+        }
+    }
+}
+
+void BasisTree::link(int i, int j) {
+    rowLinks[i].push_back(j);
+    colLinks[j].push_back(i);
+}
+
+void BasisTree::unlink(int i, int j) {
+    rowLinks[i].erase(std::find(rowLinks[i].begin(), rowLinks[i].end(), j));
+    colLinks[j].erase(std::find(colLinks[j].begin(), colLinks[j].end(), i));
+}
+
+vector<Cell> BasisTree::path(int row, int col) const {
+    vector<int> rowFrom (rowLinks.size(), -1); // column a row was reached from
+    vector<int> colFrom (colLinks.size(), -1); // row a column was reached from
+    
+    // rows are kept as themselves, columns as -1 - j
+    vector<int> queue {row};
+    rowFrom[row] = -2;
+    
+    for(auto next = 0u; colFrom[col] < 0 && next < queue.size(); ++next) {
+        auto node = queue[next];
+        if(node >= 0) {
+            for(int j : rowLinks[node]) {
+                if(colFrom[j] >= 0) continue;
+                colFrom[j] = node;
+                queue.push_back(-1 - j);
+            }
+        }
+        else {
+            auto j = -1 - node;
+            for(int i : colLinks[j]) {
+                if(rowFrom[i] != -1) continue;
+                rowFrom[i] = j;
+                queue.push_back(i);
             }
         }
     }
+    assert(colFrom[col] >= 0);
     
+    vector<Cell> ret;
+    for(int j = col; ; ) {
+        auto i = colFrom[j];
+        ret.emplace_back(i, j);
+        if(i == row) break;
+        
+        j = rowFrom[i];
+        ret.emplace_back(i, j);
+    }
     return ret;
 }
 
-static bool add_link(vector<Link>& links, Matrix& X, vector<OptInt> const& U, vector<OptInt> const& V) {
-    for(auto i = 0u; i < U.size(); ++i) {
-        if(!U[i]) {
-            for(auto j = 0u; j < V.size(); ++j) {
-                if(V[j]) {
-                    links.emplace_back(i, j);
-                    X[i][j] = EPS;
-                    return true;
+static bool even(int i) { return i % 2 == 0; }
+
+// rows and columns joined so far, for telling a cell that closes a cycle
+struct Components {
+    explicit Components(int size) : parent (size) {
+        std::iota(parent.begin(), parent.end(), 0);
+    }
+    
+    int find(int u) {
+        while(parent[u] != u) u = parent[u] = parent[parent[u]];
+        return u;
+    }
+    
+    // false if they were joined already
+    bool join(int u, int v) {
+        u = find(u);
+        v = find(v);
+        if(u == v) return false;
+        parent[u] = v;
+        return true;
+    }
+    
+    vector<int> parent;
+};
+
+// the plan is cut down to the capacities and what no longer fits goes
+// through an extra row and column, at a cost no real route can outweigh
+// (the M method); false if nothing had to be cut
+template <typename Cost, typename Qty>
+static bool bound_plan(Matrix2D<Cost>& costs, Matrix2D<Qty>& caps, Matrix2D<Qty>& X, Qty const& unlimited) {
+    auto rowsNum = X.rows();
+    auto colsNum = X.cols();
+    
+    vector<Qty> rowLeft (rowsNum, Qty {});
+    vector<Qty> colLeft (colsNum, Qty {});
+    Qty left {};
+    for(auto i = 0u; i < rowsNum; ++i) {
+        for(auto j = 0u; j < colsNum; ++j) {
+            if(X[i][j] <= caps[i][j]) continue;
+            
+            auto over = X[i][j] - caps[i][j];
+            X[i][j] = caps[i][j];
+            rowLeft[i] += over;
+            colLeft[j] += over;
+            left += over;
+        }
+    }
+    if(left == Qty {}) return false;
+    
+    Cost most {};
+    for(auto i = 0u; i < rowsNum; ++i) {
+        for(auto const& c : costs[i]) {
+            most = std::max(most, c < Cost {} ? -c : c);
+        }
+    }
+    auto M = (most + Cost(1)) * Cost(rowsNum + colsNum + 2);
+    
+    costs.resize(rowsNum + 1, colsNum + 1, M);
+    costs[rowsNum][colsNum] = Cost {};
+    caps.resize(rowsNum + 1, colsNum + 1, unlimited);
+    X.resize(rowsNum + 1, colsNum + 1, Qty {});
+    for(auto i = 0u; i < rowsNum; ++i) {
+        X[i][colsNum] = rowLeft[i];
+    }
+    for(auto j = 0u; j < colsNum; ++j) {
+        X[rowsNum][j] = colLeft[j];
+    }
+    return true;
+}
+
+// cells strictly between their bounds make the basis; one that would
+// close a cycle first moves quantity around it until some cell of the
+// cycle reaches a bound and stays out, full cells stay at their upper;
+// without capacities only the emptied cells leave, which takes the
+// cycles out of a plan that has them
+template <typename Qty>
+static void bound_basis(Matrix2D<Qty>& X, Matrix2D<Qty> const& caps, Eps& upper, BasisTree& tree) {
+    int rowsNum = X.rows();
+    int colsNum = X.cols();
+    auto capped = !caps.empty();
+    Components components (rowsNum + colsNum);
+    
+    for(int i = 0; i < rowsNum; ++i) {
+        for(int j = 0; j < colsNum; ++j) {
+            if(X[i][j] == Qty {}) continue;
+            if(capped && X[i][j] == caps[i][j]) {
+                upper[i][j] = true;
+                continue;
+            }
+            if(components.join(i, rowsNum + j)) {
+                tree.link(i, j);
+                continue;
+            }
+            
+            // the path's cells go minus, plus and so on from the column
+            auto path = tree.path(i, j);
+            Cell leaving {i, j};
+            Qty delta {};
+            if(capped) delta = caps[i][j] - X[i][j];
+            for(auto k = 0u; k < path.size(); ++k) {
+                auto const& c = path[k];
+                if(!capped && !even(k)) continue;
+                
+                auto room = even(k) ? X[c.first][c.second] : caps[c.first][c.second] - X[c.first][c.second];
+                if((!capped && leaving == Cell {i, j}) || room < delta) {
+                    delta = room;
+                    leaving = c;
                 }
             }
+            
+            X[i][j] += delta;
+            for(auto k = 0u; k < path.size(); ++k) {
+                auto const& c = path[k];
+                if(even(k)) X[c.first][c.second] -= delta;
+                else X[c.first][c.second] += delta;
+            }
+            
+            if(leaving != Cell {i, j}) {
+                tree.unlink(leaving.first, leaving.second);
+                tree.link(i, j);
+            }
+            // the cell itself and the odd ones of the path stop at their upper
+            auto full = leaving == Cell {i, j};
+            for(auto k = 0u; k < path.size(); ++k) {
+                if(path[k] == leaving) full = !even(k);
+            }
+            auto& x = X[leaving.first][leaving.second];
+            x = full ? caps[leaving.first][leaving.second] : Qty {};
+            if(capped) upper[leaving.first][leaving.second] = full;
         }
     }
-    return false;
 }
 
+// a degenerate basis falls apart into several trees, they're joined
+// by an eps cell between the first unreached row and the first reached
+// column, or the first reached row and the first unreached column
+template <typename Cost>
+static bool add_link(BasisTree& tree, Eps& eps, vector<optional<Cost>> const& U, vector<optional<Cost>> const& V, Link& added) {
+    auto unreachedRow = std::find(U.begin(), U.end(), boost::none);
+    auto reachedCol = std::find_if(V.begin(), V.end(), [](optional<Cost> const& v) { return !!v; });
+    
+    if(unreachedRow != U.end() && reachedCol != V.end()) {
+        added = {unreachedRow - U.begin(), reachedCol - V.begin()};
+    }
+    else {
+        auto reachedRow = std::find_if(U.begin(), U.end(), [](optional<Cost> const& u) { return !!u; });
+        auto unreachedCol = std::find(V.begin(), V.end(), boost::none);
+        if(unreachedCol == V.end()) return false;
+        
+        added = {reachedRow - U.begin(), unreachedCol - V.begin()};
+    }
+    
+    tree.link(added.first, added.second);
+    eps[added.first][added.second] = true;
+    return true;
+}
+
+// potentials spread from U[0] = 0 over the tree, each link is passed once
+template <typename Cost>
 static void fill_uv(
-    Matrix const& costs,
-    Matrix& X,
-    vector<int>& outU,
-    vector<int>& outV
+    Matrix2D<Cost> const& costs,
+    Eps& eps,
+    BasisTree& tree,
+    vector<Cost>& outU,
+    vector<Cost>& outV
 ) {
-    vector<OptInt> U (costs.size());
-    vector<OptInt> V (costs[0].size());
-    
-    auto links = form_links(X);
-    
-    U[0] = 0;
-    
-    // any change triggers loop repetition
-    for(bool needReps = true; needReps;) {
-        needReps = false;
-        
-        for(auto const& l : links) {
-            auto i = l.first;
-            auto j = l.second;
-            
-            if(U[i] && !V[j]) {
-                V[j] = *U[i] + costs[i][j];
-                needReps = true;
+    vector<optional<Cost>> U (costs.rows());
+    vector<optional<Cost>> V (costs.cols());
+    
+    // rows are kept as themselves, columns as -1 - j
+    vector<int> queue;
+    U[0] = Cost {};
+    queue.push_back(0);
+    
+    for(auto next = 0u; ; ) {
+        for(; next < queue.size(); ++next) {
+            auto node = queue[next];
+            if(node >= 0) {
+                for(int j : tree.rowLinks[node]) {
+                    if(V[j]) continue;
+                    V[j] = *U[node] + costs[node][j];
+                    queue.push_back(-1 - j);
+                }
             }
-            else if(V[j] && !U[i]) {
-                U[i] = *V[j] - costs[i][j];
-                needReps = true;
+            else {
+                auto j = -1 - node;
+                for(int i : tree.colLinks[j]) {
+                    if(U[i]) continue;
+                    U[i] = *V[j] - costs[i][j];
+                    queue.push_back(i);
+                }
             }
         }
         
-        if(!needReps) {
-            needReps = add_link(links, X, U, V);
+        Link added;
+        if(!add_link(tree, eps, U, V, added)) break;
+        
+        // the new cell spreads from whichever end was reached
+        if(!U[added.first]) {
+            U[added.first] = *V[added.second] - costs[added.first][added.second];
+            queue.push_back(added.first);
+        }
+        else {
+            V[added.second] = *U[added.first] + costs[added.first][added.second];
+            queue.push_back(-1 - added.second);
         }
     }
     
@@ -300,454 +760,889 @@ static void fill_uv(
     }
 }
 
-static Matrix
-get_price0(Matrix const& costs, vector<int> const& U, vector<int> const& V) {
-    Matrix ret (costs.size(), vector<int>(costs[0].size()));
+// int rows go to the kernels, the other types are looped over here
+static void price_row(int* out, int const* costs, int const* V, int u, std::size_t n) {
+    kernels::price_row(out, costs, V, u, n);
+}
+
+template <typename T>
+static void price_row(T* out, T const* costs, T const* V, T const& u, std::size_t n) {
+    for(std::size_t j = 0; j < n; ++j) {
+        out[j] = costs[j] - V[j] + u;
+    }
+}
+
+static void shift_row(int* row, int const* mask, int delta, std::size_t n) {
+    kernels::shift_row(row, mask, delta, n);
+}
+
+template <typename T>
+static void shift_row(T* row, int const* mask, T const& delta, std::size_t n) {
+    for(std::size_t j = 0; j < n; ++j) {
+        if(mask[j]) row[j] += delta;
+    }
+}
+
+static std::size_t argmin(int const* row, std::size_t n) {
+    return kernels::argmin(row, n);
+}
+
+template <typename T>
+static std::size_t argmin(T const* row, std::size_t n) {
+    std::size_t ret = 0;
+    for(std::size_t j = 1; j < n; ++j) {
+        if(row[j] < row[ret]) ret = j;
+    }
+    return ret;
+}
+
+template <typename Cost>
+static Matrix2D<Cost>
+get_price0(Matrix2D<Cost> const& costs, vector<Cost> const& U, vector<Cost> const& V) {
+    Matrix2D<Cost> ret (costs.rows(), costs.cols());
     
-    for(auto i = 0u; i < costs.size(); ++i) {
-        for(auto j = 0u; j < costs[0].size(); ++j) {
-            ret[i][j] = costs[i][j] - V[j] + U[i];
-        }
+    for(auto i = 0u; i < costs.rows(); ++i) {
+        price_row(ret[i].begin(), costs[i].begin(), V.data(), U[i], costs.cols());
     }
     
     return ret;
 }
 
-bool all_positive(Matrix const& D) {
-    for(auto const& r : D) {
-        for(int i : r) {
-            if(i < 0) return false;
+// how far a cell is from optimal, cells at their upper bound gain by
+// going down, so theirs is -D; only negative values count
+template <typename Cost>
+static Cost violation(Matrix2D<Cost> const& D, Eps const& upper, int i, int j) {
+    return !upper.empty() && upper[i][j] ? -D[i][j] : D[i][j];
+}
+
+template <typename Cost>
+static bool all_positive(Matrix2D<Cost> const& D) {
+    for(auto i = 0u; i < D.rows(); ++i) {
+        for(auto const& d : D[i]) {
+            if(d < Cost {}) return false;
         }
     }
     return true;
 }
 
-Cell most_negative_element(Matrix const& D) {
+// the cells are kept in no order, the most negative is looked for each time
+template <typename Cost>
+struct CandidateList {
+    explicit CandidateList(std::size_t size) : size {size} {}
+    
+    bool next(Matrix2D<Cost> const& D, Eps const& upper, Cell& out);
+    void refresh(Matrix2D<Cost> const& D, Eps const& upper);
+    
+    std::size_t  size;
+    vector<Cell> cells;
+};
+
+template <typename Cost>
+bool CandidateList<Cost>::next(Matrix2D<Cost> const& D, Eps const& upper, Cell& out) {
+    auto value = [&](Cell const& c) { return violation(D, upper, c.first, c.second); };
+    
+    for(int pass = 0; pass < 2; ++pass) {
+        cells.erase(std::remove_if(cells.begin(), cells.end(), [&](Cell const& c) {
+            return value(c) >= Cost {};
+        }), cells.end());
+        
+        if(!cells.empty()) {
+            out = *std::min_element(cells.begin(), cells.end(), [&](Cell const& a, Cell const& b) {
+                return value(a) < value(b) || (value(a) == value(b) && a < b);
+            });
+            return true;
+        }
+        
+        if(pass == 0) refresh(D, upper);
+    }
+    
+    return false;
+}
+
+template <typename Cost>
+void CandidateList<Cost>::refresh(Matrix2D<Cost> const& D, Eps const& upper) {
+    auto value = [&](Cell const& c) { return violation(D, upper, c.first, c.second); };
+    
+    cells.clear();
+    for(auto i = 0u; i < D.rows(); ++i) {
+        for(auto j = 0u; j < D.cols(); ++j) {
+            if(violation(D, upper, i, j) < Cost {}) cells.emplace_back(i, j);
+        }
+    }
+    
+    if(cells.size() > size) {
+        std::nth_element(cells.begin(), cells.begin() + size, cells.end(), [&](Cell const& a, Cell const& b) {
+            return value(a) < value(b);
+        });
+        cells.resize(size);
+    }
+}
+
+template <typename Cost>
+static Cell most_negative_element(Matrix2D<Cost> const& D) {
     int r = 0;
     int c = 0;
     
-    for(auto i = 0u; i < D.size(); ++i) {
-        for(auto j = 0u; j < D[0].size(); ++j) {
-            if(D[i][j] < D[r][c]) {
-                r = i;
-                c = j;
-            }
+    for(auto i = 0u; i < D.rows(); ++i) {
+        int j = argmin(D[i].begin(), D.cols());
+        if(D[i][j] < D[r][c]) {
+            r = i;
+            c = j;
         }
     }
     
     return {r, c};
 }
 
-bool even(int i) { return i % 2 == 0; }
+// the first of the most violating cells, false if there's none
+template <typename Cost>
+static bool most_violating(Matrix2D<Cost> const& D, Eps const& upper, Cell& out) {
+    auto found = false;
+    Cost least {};
+    for(auto i = 0u; i < D.rows(); ++i) {
+        for(auto j = 0u; j < D.cols(); ++j) {
+            auto v = violation(D, upper, i, j);
+            if(v < least) {
+                least = v;
+                out = {i, j};
+                found = true;
+            }
+        }
+    }
+    return found;
+}
 
-vector<Cell> mark_forbidden(
-    Matrix const& x, Cell const& mn
+enum class Sign {
+    plus, minus
+};
+
+using CycleCell = pair<Cell, Sign>;
+
+// the entering cell closes the only cycle of the tree, its cells are
+// signed in turn starting with plus at mn, or with minus if mn comes
+// down from its upper bound; the first cell in row order to reach a
+// bound leaves, the other minus cells emptied along with it stay in
+// the basis as eps; false if mn itself goes over to its other bound
+template <typename Qty>
+static bool advance_x(
+    Matrix2D<Qty>& X,
+    Eps& eps,
+    Matrix2D<Qty> const& caps,
+    Eps& upper,
+    Cell const& mn,
+    BasisTree& tree
 ) {
-    vector<Cell> ret;
+    auto capped = !caps.empty();
+    auto fromUpper = capped && upper[mn.first][mn.second];
+    
+    vector<CycleCell> cycle {{mn, fromUpper ? Sign::minus : Sign::plus}};
     
-    vector<vector<bool>> notZero (x.size(), vector<bool>(x[0].size(), false));
-    for(auto i = 0u; i < x.size(); ++i) {
-        for(auto j = 0u; j < x[0].size(); ++j) {
-            if(x[i][j] != 0) notZero[i][j] = true;
+    auto path = tree.path(mn.first, mn.second);
+    for(auto k = 0u; k < path.size(); ++k) {
+        cycle.emplace_back(path[k], even(k) != fromUpper ? Sign::minus : Sign::plus);
+    }
+    
+    // ties are settled row by row
+    std::sort(cycle.begin(), cycle.end());
+    
+    // how far a cell can go, plus cells without capacities don't stop
+    auto room = [&](CycleCell const& c, Qty& out) {
+        auto x = X[c.first.first][c.first.second];
+        if(c.second == Sign::minus) out = x;
+        else if(capped) out = caps[c.first.first][c.first.second] - x;
+        else return false;
+        return true;
+    };
+    
+    auto leaving = cycle.end();
+    Qty delta {};
+    for(auto c = cycle.begin(); c != cycle.end(); ++c) {
+        Qty r;
+        if(room(*c, r) && (leaving == cycle.end() || r < delta)) {
+            delta = r;
+            leaving = c;
         }
     }
-    notZero[mn.first][mn.second] = true;
     
-    auto direction = 0;
-    bool needStriking = true;
+    for(auto const& c : cycle) {
+        auto& x = X[c.first.first][c.first.second];
+        if(c.second == Sign::plus) x += delta;
+        else x -= delta;
+        eps[c.first.first][c.first.second] = x == Qty {};
+    }
     
-    while(needStriking) {
-        if(direction > 0) needStriking = false;
-        
-        // horizontal
-        if(even(direction)) {
-            for(auto i = 0u; i < x.size(); ++i) { // for all rows
-                int count = 0;
-                for(auto j = 0u; j < x[0].size(); ++j) {
-                    if(notZero[i][j]) {
-                        ++count;
-                    }
-                }
-                
-                if(count == 1) {
-                    for(auto j = 0u; j < x[0].size(); ++j) {
-                        ret.emplace_back(i, j);
-                        notZero[i][j] = false;
-                    }
-                    needStriking = true;
-                }
+    auto out = leaving->first;
+    auto& x = X[out.first][out.second];
+    auto full = leaving->second == Sign::plus;
+    x = full ? caps[out.first][out.second] : Qty {};
+    eps[out.first][out.second] = false;
+    if(capped) upper[out.first][out.second] = full;
+    
+    if(out == mn) return false;
+    if(capped) upper[mn.first][mn.second] = false;
+    
+    tree.link(mn.first, mn.second);
+    tree.unlink(out.first, out.second);
+    return true;
+}
+
+// the entering cell splits the tree in two, the rows and the columns on
+// the side of its row are struck; found by one walk over the tree
+template <typename Cost>
+static Matrix2D<Cost>
+advance_d(
+    Matrix2D<Cost> const& prevD,
+    BasisTree const& tree,
+    Cell const& mn
+) {
+    vector<bool> hstroke (prevD.rows());
+    vector<bool> vstroke (prevD.cols());
+    
+    // rows are kept as themselves, columns as -1 - j
+    vector<int> queue {mn.first};
+    hstroke[mn.first] = true;
+    for(auto next = 0u; next < queue.size(); ++next) {
+        auto node = queue[next];
+        if(node >= 0) {
+            for(int j : tree.rowLinks[node]) {
+                if(vstroke[j] || (node == mn.first && j == mn.second)) continue;
+                vstroke[j] = true;
+                queue.push_back(-1 - j);
             }
         }
         else {
-            for(auto j = 0u; j < x[0].size(); ++j) {
-                int count = 0;
-                for(auto i = 0u; i < x.size(); ++i) {
-                    if(notZero[i][j]) {
-                        ++count;
-                    }
-                }
-                
-                if(count == 1) {
-                    for(auto i = 0u; i < x.size(); ++i) {
-                        ret.emplace_back(i, j);
-                        notZero[i][j] = false;
-                    }
-                    needStriking = true;
-                }
+            auto j = -1 - node;
+            for(int i : tree.colLinks[j]) {
+                if(hstroke[i] || (i == mn.first && j == mn.second)) continue;
+                hstroke[i] = true;
+                queue.push_back(i);
             }
         }
-        
-        if(ret.size() == notZero.size() * notZero[0].size()) {
-            break;
-        }
-        
-        ++direction;
     }
     
-    std::sort(ret.begin(), ret.end());
-    auto last = std::unique(ret.begin(), ret.end());
-    ret.erase(last, ret.end());
+    Matrix2D<Cost> ret = prevD;
+    
+    // struck rows gain delta outside struck columns, the rest lose it in them
+    vector<int> struck (prevD.cols());
+    vector<int> notStruck (prevD.cols());
+    for(auto j = 0u; j < prevD.cols(); ++j) {
+        struck[j] = vstroke[j] ? ~0 : 0;
+        notStruck[j] = ~struck[j];
+    }
+    
+    Cost delta = -prevD[mn.first][mn.second];
+    for(auto i = 0u; i < prevD.rows(); ++i) {
+        if(hstroke[i]) shift_row(ret[i].begin(), notStruck.data(), delta, prevD.cols());
+        else shift_row(ret[i].begin(), struck.data(), Cost(-delta), prevD.cols());
+    }
     
     return ret;
 }
 
-template <typename T, typename Container>
-static bool contains(Container const& container, T const& val) {
-    for(auto const& v : container) {
-        if(v == val) return true;
+template <typename Step, typename Cost>
+static void calculate_w(Step& step, Matrix2D<Cost> const& costs) {
+    using Total = decltype(step.W);
+    for(auto i = 0u; i < costs.rows(); ++i) {
+        for(auto j = 0u; j < costs.cols(); ++j) {
+            step.W += static_cast<Total>(costs[i][j]) * static_cast<Total>(step.X[i][j]);
+        }
     }
-    return false;
 }
 
-int count_allowed(Matrix const& x, vector<Cell> const& fb, Cell const& s) {
-    int num = 0;
-    
-    unsigned si = s.first;
-    unsigned sj = s.second;
+// integral types run through the min-cost flow as long long
+template <typename T>
+using Widened = typename std::conditional<std::is_integral<T>::value, long long, T>::type;
+
+template <typename Cost, typename Qty>
+using Flows = BasicMinCostFlow<Widened<Cost>, Widened<Qty>>;
+
+// rows and columns are the nodes, every cell is an arc between them;
+// basic cells without flow are marked eps like in the potential method,
+// the ones out of the basis with flow are at their capacity
+template <typename Step, typename Cost, typename Qty>
+static vector<Step> network_steps(
+    Matrix2D<Cost> const& costs,
+    Matrix2D<Qty> const& caps,
+    vector<Qty> const& prods,
+    vector<Qty> const& consums,
+    Trace* trace
+) {
+    auto rowsNum = costs.rows();
+    auto colsNum = costs.cols();
     
-    for(auto i = 0u; i < x.size(); ++i) {
-        for(auto j = 0u; j < x[0].size(); ++j) {
-            if(i == si && j == sj) {
-                ++num;
-            }
-            else {
-                if(x[i][j] != 0 && !contains(fb, Cell{i, j})) ++num;
-            }
+    Flows<Cost, Qty> flows;
+    for(auto i = 0u; i < rowsNum; ++i) {
+        flows.add_node(prods[i]);
+    }
+    for(auto j = 0u; j < colsNum; ++j) {
+        flows.add_node(-consums[j]);
+    }
+    for(auto i = 0u; i < rowsNum; ++i) {
+        for(auto j = 0u; j < colsNum; ++j) {
+            auto arc = flows.add_arc(i, rowsNum + j, costs[i][j]);
+            if(!caps.empty()) flows.set_capacity(arc, caps[i][j]);
         }
     }
     
-    return num;
-}
-
-enum class Sign {
-    none, plus, minus
-};
-
-Sign next_sign(Sign& c) {
-    if(c == Sign::plus) {
-        c = Sign::minus;
-    }
-    else {
-        c = Sign::plus;
+    // a flattened transport always has a plan, unless capacities cut it
+    auto result = flows.solve(trace);
+    if(result.status != Flows<Cost, Qty>::Status::optimal) return {};
+    
+    Step ret;
+    ret.X = Matrix2D<Qty> (rowsNum, colsNum, Qty {});
+    ret.eps = Eps (rowsNum, colsNum, false);
+    ret.D = Matrix2D<Cost> (rowsNum, colsNum, Cost {});
+    if(!caps.empty()) ret.upper = Eps (rowsNum, colsNum, false);
+    
+    auto arc = 0;
+    for(auto i = 0u; i < rowsNum; ++i) {
+        for(auto j = 0u; j < colsNum; ++j, ++arc) {
+            ret.X[i][j] = static_cast<Qty>(result.X[arc]);
+            ret.eps[i][j] = result.eps[arc];
+            if(!caps.empty()) ret.upper[i][j] = result.upper[arc];
+            ret.D[i][j] = static_cast<Cost>(result.D[arc]);
+        }
     }
     
-    return c;
+    calculate_w(ret, costs);
+    return {ret};
 }
 
-void tryDown(
-    int& count,
-    int& si, int const sj, 
-    vector<vector<Sign>>& signs, 
-    Sign& currentSign,
-    Matrix const& x,
-    vector<Cell> const& fb
-){
-    int lastI = si;
-    for(auto i = 1u + si; i < x.size(); ++i) {
-        if(x[i][sj] != 0 && !contains(fb, Cell(i, sj))) {
-            lastI = i;
-        } 
-    }
-    if(lastI != si && signs[lastI][sj] == Sign::none) {
-        ++count;
-        si = lastI;
-        signs[si][sj] = next_sign(currentSign);
-    }
-};
+// double quantities are off by rounding, so a part of the total that
+// small counts as none; exact types have to be zero
+template <typename Qty>
+static bool negligible(Qty const& q, Qty const& total, std::true_type) {
+    auto tolerance = total * std::sqrt(std::numeric_limits<Qty>::epsilon());
+    return q <= tolerance && -q <= tolerance;
+}
 
-void tryUp(
-    int& count,
-    int& si, int const sj, 
-    vector<vector<Sign>>& signs, 
-    Sign& currentSign,
-    Matrix const& x,
-    vector<Cell> const& fb
-){
-    int lastI = si;
-    for(auto i = si - 1; i >= 0; --i) {
-        if(x[i][sj] != 0 && !contains(fb, Cell(i, sj))) {
-            lastI = i;
-        } 
-    }
-    if(lastI != si && signs[lastI][sj] == Sign::none) {
-        ++count;
-        si = lastI;
-        signs[si][sj] = next_sign(currentSign);
-    }
-};
+template <typename Qty>
+static bool negligible(Qty const& q, Qty const&, std::false_type) {
+    return q == Qty {};
+}
 
-void tryRight(
-    int& count,
-    int const si, int& sj, 
-    vector<vector<Sign>>& signs, 
-    Sign& currentSign,
-    Matrix const& x,
-    vector<Cell> const& fb
-){
-    int lastJ = sj;
-    for(auto j = 1u + sj; j < x[0].size(); ++j) {
-        if(x[si][j] != 0 && !contains(fb, Cell(si, j))) {
-            lastJ = j;
-        } 
-    }
-    if(lastJ != sj && signs[si][lastJ] == Sign::none) {
-        ++count;
-        sj = lastJ;
-        signs[si][sj] = next_sign(currentSign);
+// whether the capacities can carry the quantities of the plan at all,
+// by a flow where every cell costs the same
+template <typename Cost, typename Qty>
+static bool carries(Matrix2D<Qty> const& caps, Matrix2D<Qty> const& X) {
+    auto rowsNum = X.rows();
+    auto colsNum = X.cols();
+    
+    Flows<Cost, Qty> flows;
+    for(auto i = 0u; i < rowsNum; ++i) {
+        flows.add_node(std::accumulate(X[i].begin(), X[i].end(), Qty {}));
     }
-};
-
-void tryLeft(
-    int& count,
-    int const si, int& sj, 
-    vector<vector<Sign>>& signs, 
-    Sign& currentSign,
-    Matrix const& x,
-    vector<Cell> const& fb
-){
-    int lastJ = sj;
-    for(auto j = sj - 1; j >= 0; --j) {
-        if(x[si][j] != 0 && !contains(fb, Cell(si, j))) {
-            lastJ = j;
-        } 
-    }
-    if(lastJ != sj && signs[si][lastJ] == Sign::none) {
-        ++count;
-        sj = lastJ;
-        signs[si][sj] = next_sign(currentSign);
+    for(auto j = 0u; j < colsNum; ++j) {
+        Qty consum {};
+        for(auto i = 0u; i < rowsNum; ++i) {
+            consum += X[i][j];
+        }
+        flows.add_node(-consum);
     }
-};
-
-static Cell least_minus(
-    Matrix const& x,
-    vector<vector<Sign>> const& signs,
-    Cell const& mn
-) {
-    Cell ret = mn; // least minus marked
-    
-    for(auto i = 0u; i < x.size(); ++i) {
-        for(auto j = 0u; j < x[0].size(); ++j) {
-            if(signs[i][j] == Sign::minus) {
-                if(x[i][j] < x[ret.first][ret.second] || 
-                   signs[ret.first][ret.second] == Sign::plus)
-                {                    
-                    ret.first = i;
-                    ret.second = j;
-                }
-            }
+    for(auto i = 0u; i < rowsNum; ++i) {
+        for(auto j = 0u; j < colsNum; ++j) {
+            flows.set_capacity(flows.add_arc(i, rowsNum + j, Cost {}), caps[i][j]);
         }
     }
     
-    return ret;
+    return flows.solve().status == Flows<Cost, Qty>::Status::optimal;
 }
 
-static Matrix advance_x(
-    Matrix const& prevX, 
-    Cell const& mn
-) {    
-    auto fb = mark_forbidden(prevX, mn);
-    
-    Vector2D<Sign> signs (prevX.size(), vector<Sign>(prevX[0].size(), Sign::none));
-    int si = mn.first;
-    int sj = mn.second;
-    signs[si][sj] = Sign::plus;
-    
-    int count = 1;
-    int num = count_allowed(prevX, fb, mn);
-    
-    auto currentSign = Sign::plus;
-    
-    while(count < num) {
-        tryUp   (count, si, sj, signs, currentSign, prevX, fb);
-        tryDown (count, si, sj, signs, currentSign, prevX, fb);
-        tryRight(count, si, sj, signs, currentSign, prevX, fb);
-        tryLeft (count, si, sj, signs, currentSign, prevX, fb);
-    }
-    
-    Matrix ret = prevX;
-    
-    auto lm = least_minus(prevX, signs, mn);
-    auto delta = prevX[lm.first][lm.second];
-    
-    bool nullified = false;
-    for(auto i = 0u; i < prevX.size(); ++i) {
-        for(auto j = 0u; j < prevX[0].size(); ++j) {
-            if(signs[i][j] == Sign::minus) {
-//                ret[i][j] -= delta + (prevX[i][j] < 0 ? -EPS : 0);
-                if(delta > 0) {
-                    if(prevX[i][j] >= 0) ret[i][j] -= delta;
-                    else ret[i][j] = -delta;
-                }
-                else if(delta <= EPS) {
-                    if(prevX[i][j] <= 0) ret[i][j] -= delta;
-                    else ; // ignored
-                }
+// rows are taken in one by one, each along the shortest path of cells
+// to a free column; O(n^3) over the n x n costs. Gives the column of
+// every row, U and V price the cells like the potential method does
+template <typename Cost>
+static vector<int> hungarian(Matrix2D<Cost> const& costs, vector<Cost>& U, vector<Cost>& V) {
+    int n = costs.rows();
+    
+    // counted from 1, column 0 holds the row that's being added
+    vector<Cost> u (n + 1, Cost {});
+    vector<Cost> v (n + 1, Cost {});
+    vector<int> rowOf (n + 1, 0);
+    vector<int> way (n + 1, 0);
+    
+    vector<Cost> minv (n + 1);
+    vector<char> used (n + 1);
+    vector<char> seen (n + 1);
+    for(int i = 1; i <= n; ++i) {
+        rowOf[0] = i;
+        auto j0 = 0;
+        std::fill(used.begin(), used.end(), false);
+        std::fill(seen.begin(), seen.end(), false);
+        
+        do {
+            used[j0] = true;
+            auto i0 = rowOf[j0];
+            auto j1 = 0;
+            Cost delta {};
+            for(int j = 1; j <= n; ++j) {
+                if(used[j]) continue;
                 
-                if(ret[i][j] == 0) {
-                    if(!nullified) nullified = true;
-                    else ret[i][j] = EPS;
+                auto cur = costs[i0 - 1][j - 1] - u[i0] - v[j];
+                if(!seen[j] || cur < minv[j]) {
+                    minv[j] = cur;
+                    way[j] = j0;
+                    seen[j] = true;
                 }
-            }
-            else if(signs[i][j] == Sign::plus) {
-//                ret[i][j] += delta + (prevX[i][j] < 0 ? -EPS : 0);
-                
-                if(delta > 0) {
-                    if(prevX[i][j] >= 0) ret[i][j] += delta;
-                    else ret[i][j] = delta;
+                if(j1 == 0 || minv[j] < delta) {
+                    delta = minv[j];
+                    j1 = j;
                 }
-                else if(delta <= EPS) {
-                    if(prevX[i][j] <= 0) ret[i][j] += delta;
-                    else ; // ignored
+            }
+            for(int j = 0; j <= n; ++j) {
+                if(used[j]) {
+                    u[rowOf[j]] += delta;
+                    v[j] -= delta;
                 }
-                
-                if(ret[i][j] == 0) {
-                    if(!nullified) nullified = true;
-                    else ret[i][j] = EPS;
+                else {
+                    minv[j] -= delta;
                 }
             }
-        }
+            j0 = j1;
+        } while(rowOf[j0] != 0);
+        
+        do {
+            auto j1 = way[j0];
+            rowOf[j0] = rowOf[j1];
+            j0 = j1;
+        } while(j0 != 0);
+    }
+    
+    vector<int> ret (n);
+    for(int j = 1; j <= n; ++j) {
+        ret[rowOf[j] - 1] = j - 1;
     }
     
+    U.resize(n);
+    V.resize(n);
+    for(int i = 0; i < n; ++i) {
+        U[i] = -u[i + 1];
+        V[i] = v[i + 1];
+    }
     return ret;
-};
+}
 
-static Matrix
-advance_d(
-    Matrix const& prevD,
-    Matrix const& X, 
-    Cell const& mn
+// the assigned cells alone make n separate links, they're joined into
+// a basis by eps cells of zero D; where there's none between the linked
+// part and the rest, the linked part's potentials are shifted until
+// the cheapest cell across comes down to zero (the way Prim grows
+// a spanning tree), which keeps every D at or over zero
+template <typename Cost>
+static void assignment_basis(
+    Matrix2D<Cost> const& costs,
+    vector<int> const& colOf,
+    vector<Cost>& U,
+    vector<Cost>& V,
+    Eps& eps
 ) {
-    Vector2D<bool> notZero (X.size(), vector<bool>(X[0].size()));
-    for(auto i = 0u; i < X.size(); ++i) {
-        for(auto j = 0u; j < X[0].size(); ++j) {
-            if(X[i][j] != 0) notZero[i][j] = true;
+    int n = costs.rows();
+    
+    // rows go in along with their columns, so both are kept by row: the
+    // least D from the linked part to row k and to the column of row k
+    vector<char> linked (n, false);
+    vector<Cost> rowSlack (n);
+    vector<int>  rowFrom (n, -1);
+    vector<Cost> colSlack (n);
+    vector<int>  colFrom (n, -1);
+    vector<int>  linkedRows;
+    
+    auto link = [&](int i) {
+        auto j = colOf[i];
+        linked[i] = true;
+        linkedRows.push_back(i);
+        for(int k = 0; k < n; ++k) {
+            if(linked[k]) continue;
+            
+            auto d = costs[k][j] + U[k] - V[j];
+            if(rowFrom[k] < 0 || d < rowSlack[k]) {
+                rowSlack[k] = d;
+                rowFrom[k] = j;
+            }
+            d = costs[i][colOf[k]] + U[i] - V[colOf[k]];
+            if(colFrom[k] < 0 || d < colSlack[k]) {
+                colSlack[k] = d;
+                colFrom[k] = i;
+            }
         }
-    }
-    vector<bool> hstroke (X.size());
-    vector<bool> vstroke (X[0].size());
-    for(auto i = 0u; i < X[0].size(); ++i) {
-        hstroke[mn.first] = true;
-    }
-    
-    unsigned mi = mn.first;
-    unsigned mj = mn.second;
-    
-    bool needStriking = true;
-    int  direction = 0;
-    while(needStriking) {
-        needStriking = false;
-        
-        if(even(direction)) { // vertical striking
-            for(auto i = 0u; i < X.size(); ++i) {
-                for(auto j = 0u; j < X[0].size(); ++j) {
-                    if(i == mi && j == mj) continue;
-                    
-                    if(hstroke[i] && !vstroke[j] && notZero[i][j]) {
-                        vstroke[j] = true;
-                        needStriking = true;
-                    }
-                }
+    };
+    
+    link(0);
+    for(int added = 1; added < n; ++added) {
+        auto next = -1;
+        auto byRow = true;
+        Cost least {};
+        for(int k = 0; k < n; ++k) {
+            if(linked[k]) continue;
+            if(next < 0 || rowSlack[k] < least) {
+                least = rowSlack[k];
+                next = k;
+                byRow = true;
+            }
+            if(colSlack[k] < least) {
+                least = colSlack[k];
+                next = k;
+                byRow = false;
             }
         }
-        else { // horizontal striking
-            for(auto j = 0u; j < X[0].size(); ++j) {
-                for(auto i = 0u; i < X.size(); ++i) {
-                    if(i == mi && j == mj) continue;
-                    
-                    if(vstroke[j] && !hstroke[i] && notZero[i][j]) {
-                        hstroke[i] = true;
-                        needStriking = true;
-                    }
-                }
+        
+        // U and V of the linked part move together, its own cells keep
+        // their D while the cells across trade it between rows and columns
+        if(least != Cost {}) {
+            auto shift = byRow ? least : -least;
+            for(int i : linkedRows) {
+                U[i] += shift;
+                V[colOf[i]] += shift;
+            }
+            for(int k = 0; k < n; ++k) {
+                if(linked[k]) continue;
+                rowSlack[k] -= shift;
+                colSlack[k] += shift;
             }
         }
         
-        ++direction;
+        if(byRow) eps[next][rowFrom[next]] = true;
+        else eps[colFrom[next]][colOf[next]] = true;
+        link(next);
+    }
+}
+
+template <typename Step, typename Cost, typename Qty>
+static vector<Step> assignment_steps(Matrix2D<Cost> const& costs, Trace* trace) {
+    auto n = costs.rows();
+    
+    vector<Cost> U, V;
+    vector<int> colOf;
+    {
+        Trace::Span span {trace, "hungarian"};
+        colOf = hungarian(costs, U, V);
     }
     
-    Matrix ret = prevD;
-    
-    auto delta = std::abs(prevD[mn.first][mn.second]);
-    for(auto i = 0u; i < X.size(); ++i) {
-        for(auto j = 0u; j < X[0].size(); ++j) {
-            if(hstroke[i] && !vstroke[j]) ret[i][j] += delta;
-            else if(vstroke[j] && !hstroke[i]) ret[i][j] -= delta;
-        }
+    Step ret;
+    ret.X = Matrix2D<Qty> (n, n, Qty {});
+    ret.eps = Eps (n, n, false);
+    for(auto i = 0u; i < n; ++i) {
+        ret.X[i][colOf[i]] = Qty(1);
+    }
+    {
+        Trace::Span span {trace, "basis"};
+        assignment_basis(costs, colOf, U, V, ret.eps);
+    }
+    {
+        Trace::Span span {trace, "prices"};
+        ret.D = get_price0(costs, U, V);
     }
     
-    return ret;
+    calculate_w(ret, costs);
+    return {ret};
 }
 
-static void calculate_w(BalanceMatrix::Step& step, Matrix const& costs) {
-    for(auto i = 0u; i < costs.size(); ++i) {
-        for(auto j = 0u; j < costs[0].size(); ++j) {
-            if(step.X[i][j] > 0) {
-                step.W += costs[i][j] * step.X[i][j];
-            }
-        }
+// the auction works in whole numbers, other types get no plan from it
+template <typename Cost, typename Qty>
+static bool auction_plan(
+    Matrix2D<Cost> const&, vector<Qty> const&, vector<Qty> const&,
+    unsigned, Matrix2D<Qty>&, Trace*, std::false_type
+) {
+    return false;
+}
+
+template <typename Cost, typename Qty>
+static bool auction_plan(
+    Matrix2D<Cost> const& costs,
+    vector<Qty> const& prods,
+    vector<Qty> const& consums,
+    unsigned threadsNum,
+    Matrix2D<Qty>& X,
+    Trace* trace,
+    std::true_type
+) {
+    Matrix2D<long long> wide (costs.rows(), costs.cols());
+    for(auto i = 0u; i < costs.rows(); ++i) {
+        std::copy(costs[i].begin(), costs[i].end(), wide[i].begin());
     }
+    
+    Auction auction {threadsNum};
+    auto plan = auction.solve(
+        wide,
+        vector<long long> (prods.begin(), prods.end()),
+        vector<long long> (consums.begin(), consums.end()),
+        trace
+    );
+    if(plan.empty()) return false;
+    
+    X = Matrix2D<Qty> (plan.rows(), plan.cols());
+    for(auto i = 0u; i < plan.rows(); ++i) {
+        std::transform(plan[i].begin(), plan[i].end(), X[i].begin(), [](long long x) {
+            return static_cast<Qty>(x);
+        });
+    }
+    return true;
 }
 
-auto BalanceMatrix::solve(Meth const& m) const -> vector<Step> {
+template <typename Cost, typename Qty>
+auto BasicBalanceMatrix<Cost, Qty>::solve(Meth const& m, Trace* trace) const -> vector<Step> {
+    return solve(m, Options {}, trace);
+}
+
+template <typename Cost, typename Qty>
+auto BasicBalanceMatrix<Cost, Qty>::solve(Meth const& m, Options const& options, Trace* trace) const -> vector<Step> {
     if(_costs.empty()) return {};
     
+    Trace::Span span {trace, "solve"};
+    
+    if(m == Meth::Network) {
+        auto costs   = _costs;
+        auto prods   = _prods;
+        auto consums = _consums;
+        {
+            Trace::Span span {trace, "flatten"};
+            flatten(costs, prods, consums);
+        }
+        
+        auto caps = _caps;
+        if(!caps.empty()) {
+            caps.resize(costs.rows(), costs.cols(), std::accumulate(prods.begin(), prods.end(), Qty {}));
+        }
+        
+        auto ret = network_steps<Step>(costs, caps, prods, consums, trace);
+        if(options.onStep && !ret.empty()) options.onStep(ret.back());
+        return ret;
+    }
+    
+    if(m == Meth::Assignment) {
+        auto unit = [](Qty const& q) { return q == Qty(1); };
+        if(!_caps.empty() || _prods.size() != _consums.size()
+        || !std::all_of(_prods.begin(), _prods.end(), unit)
+        || !std::all_of(_consums.begin(), _consums.end(), unit)) {
+            return {};
+        }
+        
+        auto ret = assignment_steps<Step, Cost, Qty>(_costs, trace);
+        if(options.onStep) options.onStep(ret.back());
+        return ret;
+    }
+    
     /*setup*/
-    vector<int> consums;
-    vector<int> prods;
-    Matrix costs;
+    vector<Qty> consums;
+    vector<Qty> prods;
+    Matrix2D<Cost> costs;
     Step s;
     if(m == Meth::NW) {
-        s.X = get_key0_by_nw_method(&consums, &prods, &costs);
+        s.X = get_key0_by_nw_method(&consums, &prods, &costs, trace);
+    }
+    else if(m == Meth::Vogel) {
+        s.X = get_key0_by_vogel_method(&consums, &prods, &costs, trace);
+    }
+    else if(m == Meth::Auction) {
+        costs   = _costs;
+        prods   = _prods;
+        consums = _consums;
+        {
+            Trace::Span span {trace, "flatten"};
+            flatten(costs, prods, consums);
+        }
+        
+        using Integral = std::integral_constant<bool, std::is_integral<Cost>::value && std::is_integral<Qty>::value>;
+        if(!auction_plan(costs, prods, consums, options.threadsNum, s.X, trace, Integral {})) return {};
     }
     else {
-        s.X = get_key0_by_min_method(&consums, &prods, &costs);
+        s.X = get_key0_by_min_method(&consums, &prods, &costs, trace);
     }
     
-    vector<int> U, V;
-    fill_uv(costs, s.X, U, V);
+    // the initial plans don't see the capacities, they're cut down to
+    // them here; the dummy line of flatten takes any quantity
+    Matrix2D<Qty> caps;
+    auto bridged = false;
+    Qty unlimited {};
+    if(!_caps.empty()) {
+        Trace::Span span {trace, "bounds"};
+        
+        unlimited = std::accumulate(_prods.begin(), _prods.end(), Qty {});
+        unlimited += std::accumulate(_consums.begin(), _consums.end(), Qty {});
+        caps = _caps;
+        caps.resize(costs.rows(), costs.cols(), unlimited);
+        
+        // onStep sees no steps of a plan that can't be had
+        if(!carries<Cost>(caps, s.X)) return {};
+        bridged = bound_plan(costs, caps, s.X, unlimited);
+    }
     
-    assert(U.size() == consums.size());
-    assert(V.size() == prods.size());
+    s.eps = Eps (s.X.rows(), s.X.cols(), false);
     
-    s.D = get_price0(costs, U, V);
+    // the auction's plan can have cycles, the others' can't
+    BasisTree tree {s.X.rows(), s.X.cols()};
+    if(caps.empty() && m != Meth::Auction) {
+        tree = BasisTree {s.X, s.eps};
+    }
+    else {
+        if(!caps.empty()) s.upper = Eps (s.X.rows(), s.X.cols(), false);
+        bound_basis(s.X, caps, s.upper, tree);
+    }
+    
+    vector<Cost> U, V;
+    {
+        Trace::Span span {trace, "potentials"};
+        fill_uv(costs, s.eps, tree, U, V);
+    }
+    
+    // full cells linked in to join the trees are basic now
+    for(auto i = 0u; i < s.upper.rows(); ++i) {
+        for(auto j = 0u; j < s.upper.cols(); ++j) {
+            if(s.upper[i][j] && s.eps[i][j]) s.upper[i][j] = s.eps[i][j] = false;
+        }
+    }
+    
+    {
+        Trace::Span span {trace, "prices"};
+        s.D = get_price0(costs, U, V);
+    }
     
     calculate_w(s, costs);
-    vector<Step> ret {s};
     
-    while(!all_positive(s.D)) {
-        auto mn = most_negative_element(s.D);
+    // the current step goes in only if it's recorded, the last one is
+    // added after the loop if it wasn't
+    vector<Step> ret;
+    auto record = [&](Step const& step, int iteration) {
+        if(options.onStep) options.onStep(step);
+        
+        auto every = std::max(1u, options.recordEvery);
+        if(options.record == Record::all || (options.record == Record::every && iteration % every == 0)) {
+            ret.push_back(step);
+            return true;
+        }
+        return false;
+    };
+    auto recorded = record(s, 0);
+    
+    auto candidatesNum = options.candidatesNum;
+    if(candidatesNum == 0) {
+        candidatesNum = std::max(10u, static_cast<unsigned>(std::sqrt(costs.rows() * costs.cols())));
+    }
+    CandidateList<Cost> candidates {candidatesNum};
+    
+    for(int iteration = 1; ; ++iteration) {
+        Trace::Span iterationSpan {trace, "iteration", iteration};
+        
+        Cell mn;
+        {
+            Trace::Span span {trace, "pricing"};
+            if(options.pricing == Pricing::candidates) {
+                if(!candidates.next(s.D, s.upper, mn)) break;
+            }
+            else if(caps.empty()) {
+                if(all_positive(s.D)) break;
+                mn = most_negative_element(s.D);
+            }
+            else {
+                if(!most_violating(s.D, s.upper, mn)) break;
+            }
+        }
         
         Step ns;
-        ns.X = advance_x(s.X, mn);
-        ns.D = advance_d(s.D, ns.X, mn);
+        bool pivoted;
+        {
+            Trace::Span span {trace, "advance_x"};
+            ns.X = s.X;
+            ns.eps = s.eps;
+            ns.upper = s.upper;
+            pivoted = advance_x(ns.X, ns.eps, caps, ns.upper, mn, tree);
+        }
+        {
+            Trace::Span span {trace, "advance_d"};
+            ns.D = pivoted ? advance_d(s.D, tree, mn) : s.D;
+        }
         calculate_w(ns, costs);
-        ret.push_back(ns);
-        s = ns;
+        
+        s = std::move(ns);
+        recorded = record(s, iteration);
     }
     
+    // quantity left on the extra line has no real route; the capacities
+    // were checked to carry the plan, so this only catches an extra line
+    // that its cost didn't price out
+    if(bridged) {
+        auto r = s.X.rows() - 1;
+        auto c = s.X.cols() - 1;
+        std::is_floating_point<Qty> floating;
+        for(auto i = 0u; i < r; ++i) {
+            if(!negligible(s.X[i][c], unlimited, floating)) return {};
+        }
+        for(auto j = 0u; j < c; ++j) {
+            if(!negligible(s.X[r][j], unlimited, floating)) return {};
+        }
+    }
+    
+    if(!recorded) ret.push_back(std::move(s));
+    
     return ret;
 }
 
-bool BalanceMatrix::Step::valid() const {
-    return all_positive(D);
+// the min-cost flow takes the imbalance the way flatten's dummy line
+// would, at no cost
+template <typename Cost, typename Qty>
+auto BasicBalanceMatrix<Cost, Qty>::solve_arcs(Trace* trace) const -> vector<ArcsStep> {
+    if(_arcs.empty()) return {};
+    
+    Trace::Span span {trace, "solve_arcs"};
+    
+    int rowsNum = _prods.size();
+    
+    Flows<Cost, Qty> flows;
+    for(auto const& p : _prods) {
+        flows.add_node(p);
+    }
+    for(auto const& c : _consums) {
+        flows.add_node(-c);
+    }
+    for(auto const& a : _arcs) {
+        flows.add_arc(a.source, rowsNum + a.sink, a.cost);
+    }
+    
+    auto result = flows.solve(trace);
+    if(result.status != Flows<Cost, Qty>::Status::optimal) return {};
+    
+    ArcsStep ret;
+    ret.X.reserve(_arcs.size());
+    ret.eps.reserve(_arcs.size());
+    ret.D.reserve(_arcs.size());
+    
+    for(auto k = 0u; k < _arcs.size(); ++k) {
+        ret.X.push_back(static_cast<Qty>(result.X[k]));
+        ret.eps.push_back(result.eps[k]);
+        ret.D.push_back(static_cast<Cost>(result.D[k]));
+        ret.W += static_cast<Total>(_arcs[k].cost) * static_cast<Total>(ret.X.back());
+    }
+    
+    return {ret};
+}
+
+template <typename Cost, typename Qty>
+bool BasicBalanceMatrix<Cost, Qty>::Step::valid() const {
+    if(upper.empty()) return all_positive(D);
+    
+    Cell mn;
+    return !most_violating(D, upper, mn);
+}
+
+template <typename Cost, typename Qty>
+bool BasicBalanceMatrix<Cost, Qty>::ArcsStep::valid() const {
+    return std::none_of(D.begin(), D.end(), [](Cost const& d) { return d < Cost {}; });
 }
+
+template class BasicBalanceMatrix<int>;
+template class BasicBalanceMatrix<long long>;
+template class BasicBalanceMatrix<double>;
+template class BasicBalanceMatrix<Fraction>;
+
+template std::ostream& operator <<(std::ostream&, BasicBalanceMatrix<int> const&);
+template std::ostream& operator <<(std::ostream&, BasicBalanceMatrix<long long> const&);
+template std::ostream& operator <<(std::ostream&, BasicBalanceMatrix<double> const&);
+template std::ostream& operator <<(std::ostream&, BasicBalanceMatrix<Fraction> const&);
+
+template void print_vec2d(std::ostream&, Matrix2D<int> const&);
+template void print_vec2d(std::ostream&, Matrix2D<long long> const&);
+template void print_vec2d(std::ostream&, Matrix2D<double> const&);
+template void print_vec2d(std::ostream&, Matrix2D<Fraction> const&);
+template void print_vec2d(std::ostream&, Matrix2D<int> const&, Eps const&);
+template void print_vec2d(std::ostream&, Matrix2D<long long> const&, Eps const&);
+template void print_vec2d(std::ostream&, Matrix2D<double> const&, Eps const&);
+template void print_vec2d(std::ostream&, Matrix2D<Fraction> const&, Eps const&);
@@ -1,54 +1,172 @@
 #ifndef BALANCEMATRIX_H_INCLUDED
 #define BALANCEMATRIX_H_INCLUDED
 
+#include "Matrix2D.h"
+
+#include <functional>
 #include <initializer_list>
+#include <type_traits>
 #include <vector>
 #include <iosfwd>
 
-class BalanceMatrix {
+class Trace;
+
+// transport problem with costs of one type and quantities of another;
+// instantiated for int, long long, double and Fraction
+template <typename Cost, typename Qty = Cost>
+class BasicBalanceMatrix {
 public:
-    BalanceMatrix() = default;
-    bool set(std::initializer_list<std::vector<int>> const& rows);
-    bool set(std::vector<std::vector<int>> const& rows);
-    
-    std::vector<std::vector<int>> get_key0_by_nw_method(
-        std::vector<int>* outProds   = nullptr,
-        std::vector<int>* outConsums = nullptr,
-        std::vector<std::vector<int>>* outCosts = nullptr
+    // integral totals are widened, int costs by int quantities overflow early
+    using Total = typename std::conditional<
+        std::is_integral<decltype(Cost {} * Qty {})>::value,
+        long long,
+        decltype(Cost {} * Qty {})
+    >::type;
+    
+    struct Arc;
+    
+    BasicBalanceMatrix() = default;
+    bool set(std::initializer_list<std::vector<Cost>> const& rows);
+    bool set(std::vector<std::vector<Cost>> const& rows);
+    bool set(Matrix2D<Cost> const& costs, std::vector<Qty> const& prods, std::vector<Qty> const& consums);
+    
+    // only the allowed routes are kept, the dense methods see no costs then
+    bool set(std::vector<Arc> const& arcs, std::vector<Qty> const& prods, std::vector<Qty> const& consums);
+    
+    // upper bounds on X by cell, an empty matrix takes them off;
+    // setting the costs takes them off too
+    bool set_capacities(Matrix2D<Qty> const& caps);
+    
+    Matrix2D<Qty> get_key0_by_nw_method(
+        std::vector<Qty>* outProds   = nullptr,
+        std::vector<Qty>* outConsums = nullptr,
+        Matrix2D<Cost>* outCosts = nullptr,
+        Trace* trace = nullptr
     ) const;
     
-    std::vector<std::vector<int>> get_key0_by_min_method(
-        std::vector<int>* outProds   = nullptr,
-        std::vector<int>* outConsums = nullptr,
-        std::vector<std::vector<int>>* outCosts = nullptr
+    Matrix2D<Qty> get_key0_by_min_method(
+        std::vector<Qty>* outProds   = nullptr,
+        std::vector<Qty>* outConsums = nullptr,
+        Matrix2D<Cost>* outCosts = nullptr,
+        Trace* trace = nullptr
     ) const;
     
+    // the cheapest cell of the line with the largest difference between
+    // its two cheapest cells goes first
+    Matrix2D<Qty> get_key0_by_vogel_method(
+        std::vector<Qty>* outProds   = nullptr,
+        std::vector<Qty>* outConsums = nullptr,
+        Matrix2D<Cost>* outCosts = nullptr,
+        Trace* trace = nullptr
+    ) const;
+    
+    // Network solves by the network simplex and gives only the last step;
+    // with capacities the potential method keeps the cells at their upper
+    // bound out of the basis, what the initial plan puts over them goes
+    // through an extra row and column at a prohibitive cost, which the
+    // steps keep; solve() gives nothing if the capacities can't carry
+    // the plan;
+    // Assignment is for square problems with every quantity 1 and no
+    // capacities, it solves them by the Hungarian method and gives only
+    // the last step; other problems get nothing;
+    // Auction starts the potential method from the plan of the parallel
+    // auction, which is already optimal without capacities, so the steps
+    // after the first only settle the basis; for integral types only
     enum class Meth {
-        NW, Min
+        NW, Min, Vogel, Network, Assignment, Auction
+    };
+    
+    enum class Pricing {
+        full, candidates
+    };
+    
+    // which steps solve() returns, the last one is always there
+    enum class Record {
+        all, last, every
     };
     
     struct Step;
-    std::vector<Step> solve(Meth const& m) const;
-
-    friend std::ostream& operator <<(std::ostream& os, BalanceMatrix const& m);
+    struct Options;
+    std::vector<Step> solve(Meth const& m, Trace* trace = nullptr) const;
+    std::vector<Step> solve(Meth const& m, Options const& options, Trace* trace = nullptr) const;
+    
+    // the routes set as arcs by the min-cost flow, which keeps to them
+    // alone; empty if they can't carry the plan
+    struct ArcsStep;
+    std::vector<ArcsStep> solve_arcs(Trace* trace = nullptr) const;
+    
+    template <typename C, typename Q>
+    friend std::ostream& operator <<(std::ostream& os, BasicBalanceMatrix<C, Q> const& m);
 private:
-    std::vector<std::vector<int>> _costs;
-    std::vector<int> _prods;
-    std::vector<int> _consums;
+    Matrix2D<Cost> _costs;
+    std::vector<Qty> _prods;
+    std::vector<Qty> _consums;
+    Matrix2D<Qty> _caps;
+    std::vector<Arc> _arcs;
+};
+
+using BalanceMatrix = BasicBalanceMatrix<int>;
+
+// full looks through the whole D for the most negative cell every step;
+// candidates keeps the most negative cells of the last such look and
+// looks again only once none of them is negative, the network simplex
+// has its own pricing
+template <typename Cost, typename Qty>
+struct BasicBalanceMatrix<Cost, Qty>::Options {
+    Pricing  pricing = Pricing::full;
+    unsigned candidatesNum = 0; // 0 for about the square root of the cells count
+    
+    Record   record = Record::all;
+    unsigned recordEvery = 1; // with Record::every, the first step is kept too
+    
+    // sees every step as it's made, whatever is recorded; a solve that
+    // the capacities can't carry gives none
+    std::function<void(Step const&)> onStep;
+    
+    unsigned threadsNum = 0; // for Auction, 0 for one per hardware thread
 };
 
-struct BalanceMatrix::Step {
-    std::vector<std::vector<int>> X;
-    std::vector<std::vector<int>> D;
-    int W = 0;
+// degenerate basic cells carry no quantity, they're marked in eps;
+// upper marks the cells out of the basis at their capacity, it's
+// empty without capacities
+template <typename Cost, typename Qty>
+struct BasicBalanceMatrix<Cost, Qty>::Step {
+    Matrix2D<Qty>  X;
+    Matrix2D<char> eps;
+    Matrix2D<char> upper;
+    Matrix2D<Cost> D;
+    Total W {};
     
     bool valid() const;
 };
 
-void print_vec2d(
-    std::ostream& os, 
-    std::vector<std::vector<int>> const& vec2d, 
-    bool eps_is_minus_one = false
-);
+template <typename Cost, typename Qty>
+struct BasicBalanceMatrix<Cost, Qty>::Arc {
+    int  source;
+    int  sink;
+    Cost cost;
+};
+
+// the items go by the arcs in the order they were set,
+// D holds their reduced costs
+template <typename Cost, typename Qty>
+struct BasicBalanceMatrix<Cost, Qty>::ArcsStep {
+    std::vector<Qty>  X;
+    std::vector<char> eps;
+    std::vector<Cost> D;
+    Total W {};
+    
+    bool valid() const;
+};
+
+template <typename Cost, typename Qty>
+std::ostream& operator <<(std::ostream& os, BasicBalanceMatrix<Cost, Qty> const& m);
+
+template <typename T>
+void print_vec2d(std::ostream& os, Matrix2D<T> const& vec2d);
+
+// cells marked in eps get an E after them
+template <typename T>
+void print_vec2d(std::ostream& os, Matrix2D<T> const& vec2d, Matrix2D<char> const& eps);
 
 #endif
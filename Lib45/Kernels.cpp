@@ -0,0 +1,129 @@
+#include "Kernels.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define KERNELS_AVX2
+#include <immintrin.h>
+#endif
+
+namespace kernels {
+    namespace scalar {
+        void price_row(int* out, int const* costs, int const* V, int u, std::size_t n) {
+            for(std::size_t j = 0; j < n; ++j) {
+                out[j] = costs[j] - V[j] + u;
+            }
+        }
+        
+        void shift_row(int* row, int const* mask, int delta, std::size_t n) {
+            for(std::size_t j = 0; j < n; ++j) {
+                row[j] += delta & mask[j];
+            }
+        }
+        
+        std::size_t argmin(int const* row, std::size_t n) {
+            std::size_t ret = 0;
+            for(std::size_t j = 1; j < n; ++j) {
+                if(row[j] < row[ret]) ret = j;
+            }
+            return ret;
+        }
+    }
+    
+#ifdef KERNELS_AVX2
+    namespace avx2 {
+        __attribute__((target("avx2")))
+        void price_row(int* out, int const* costs, int const* V, int u, std::size_t n) {
+            auto vu = _mm256_set1_epi32(u);
+            
+            std::size_t j = 0;
+            for(; j + 8 <= n; j += 8) {
+                auto c = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(costs + j));
+                auto v = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(V + j));
+                auto d = _mm256_add_epi32(_mm256_sub_epi32(c, v), vu);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + j), d);
+            }
+            scalar::price_row(out + j, costs + j, V + j, u, n - j);
+        }
+        
+        __attribute__((target("avx2")))
+        void shift_row(int* row, int const* mask, int delta, std::size_t n) {
+            auto vdelta = _mm256_set1_epi32(delta);
+            
+            std::size_t j = 0;
+            for(; j + 8 <= n; j += 8) {
+                auto r = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(row + j));
+                auto m = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(mask + j));
+                r = _mm256_add_epi32(r, _mm256_and_si256(vdelta, m));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(row + j), r);
+            }
+            scalar::shift_row(row + j, mask + j, delta, n - j);
+        }
+        
+        // every lane keeps its own first least item, the lanes are
+        // merged by value and then by index
+        __attribute__((target("avx2")))
+        std::size_t argmin(int const* row, std::size_t n) {
+            if(n < 16) return scalar::argmin(row, n);
+            
+            auto best = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(row));
+            auto bestIndex = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+            auto index = bestIndex;
+            auto step = _mm256_set1_epi32(8);
+            
+            std::size_t j = 8;
+            for(; j + 8 <= n; j += 8) {
+                index = _mm256_add_epi32(index, step);
+                auto r = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(row + j));
+                auto less = _mm256_cmpgt_epi32(best, r);
+                best = _mm256_blendv_epi8(best, r, less);
+                bestIndex = _mm256_blendv_epi8(bestIndex, index, less);
+            }
+            
+            alignas(32) int values[8];
+            alignas(32) int indices[8];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(values), best);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(indices), bestIndex);
+            
+            std::size_t ret = indices[0];
+            for(int k = 1; k < 8; ++k) {
+                if(values[k] < row[ret] || (values[k] == row[ret] && std::size_t(indices[k]) < ret)) {
+                    ret = indices[k];
+                }
+            }
+            for(; j < n; ++j) {
+                if(row[j] < row[ret]) ret = j;
+            }
+            return ret;
+        }
+    }
+#endif
+    
+    bool uses_avx2() {
+#ifdef KERNELS_AVX2
+        static bool const ret = __builtin_cpu_supports("avx2");
+        return ret;
+#else
+        return false;
+#endif
+    }
+    
+    void price_row(int* out, int const* costs, int const* V, int u, std::size_t n) {
+#ifdef KERNELS_AVX2
+        if(uses_avx2()) return avx2::price_row(out, costs, V, u, n);
+#endif
+        scalar::price_row(out, costs, V, u, n);
+    }
+    
+    void shift_row(int* row, int const* mask, int delta, std::size_t n) {
+#ifdef KERNELS_AVX2
+        if(uses_avx2()) return avx2::shift_row(row, mask, delta, n);
+#endif
+        scalar::shift_row(row, mask, delta, n);
+    }
+    
+    std::size_t argmin(int const* row, std::size_t n) {
+#ifdef KERNELS_AVX2
+        if(uses_avx2()) return avx2::argmin(row, n);
+#endif
+        return scalar::argmin(row, n);
+    }
+}
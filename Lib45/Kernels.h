@@ -0,0 +1,28 @@
+#ifndef KERNELS_H_INCLUDED
+#define KERNELS_H_INCLUDED
+
+#include <cstddef>
+
+// inner loops over matrix rows; the first call checks what the CPU has
+// and picks the AVX2 version if it can, the scalar ones give the same
+// results bit for bit and are kept callable for comparison
+namespace kernels {
+    // out[j] = costs[j] - V[j] + u
+    void price_row(int* out, int const* costs, int const* V, int u, std::size_t n);
+    
+    // row[j] += delta & mask[j], masks are 0 or all ones
+    void shift_row(int* row, int const* mask, int delta, std::size_t n);
+    
+    // index of the first least item, 0 for an empty row
+    std::size_t argmin(int const* row, std::size_t n);
+    
+    bool uses_avx2();
+    
+    namespace scalar {
+        void price_row(int* out, int const* costs, int const* V, int u, std::size_t n);
+        void shift_row(int* row, int const* mask, int delta, std::size_t n);
+        std::size_t argmin(int const* row, std::size_t n);
+    }
+}
+
+#endif
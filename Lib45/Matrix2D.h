@@ -0,0 +1,120 @@
+#ifndef MATRIX2D_H_INCLUDED
+#define MATRIX2D_H_INCLUDED
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// row-major matrix in one block, rows start every stride() items;
+// bool grids are kept as char, vector<bool> has no data() to point into
+template <typename T>
+class Matrix2D {
+public:
+    // a row of the matrix, valid while the matrix isn't resized
+    template <typename Item>
+    class RowView {
+    public:
+        RowView(Item* data, std::size_t size) : _data {data}, _size {size} {}
+        
+        Item& operator [](std::size_t j) const { return _data[j]; }
+        std::size_t size() const { return _size; }
+        
+        Item* begin() const { return _data; }
+        Item* end() const { return _data + _size; }
+    
+    private:
+        Item*       _data;
+        std::size_t _size;
+    };
+    
+    using Row      = RowView<T>;
+    using ConstRow = RowView<T const>;
+    
+    Matrix2D() = default;
+    
+    Matrix2D(std::size_t rows, std::size_t cols, T const& value = T {})
+    : _rows   {rows}
+    , _cols   {cols}
+    , _stride {cols}
+    , _items  (rows * cols, value)
+    {}
+    
+    // every row has to be as long as the first
+    explicit Matrix2D(std::vector<std::vector<T>> const& rows)
+    : Matrix2D(rows.size(), rows.empty() ? 0 : rows.front().size())
+    {
+        for(auto i = 0u; i < _rows; ++i) {
+            if(rows[i].size() != _cols) throw std::invalid_argument {"ragged rows"};
+            std::copy(rows[i].begin(), rows[i].begin() + _cols, (*this)[i].begin());
+        }
+    }
+    
+    std::size_t rows() const { return _rows; }
+    std::size_t cols() const { return _cols; }
+    std::size_t stride() const { return _stride; }
+    bool empty() const { return _rows == 0 || _cols == 0; }
+    
+    // by pointer, a matrix without columns has no items to index
+    Row operator [](std::size_t i) { return {_items.data() + i * _stride, _cols}; }
+    ConstRow operator [](std::size_t i) const { return {_items.data() + i * _stride, _cols}; }
+    
+    T& operator ()(std::size_t i, std::size_t j) { return _items[i * _stride + j]; }
+    T const& operator ()(std::size_t i, std::size_t j) const { return _items[i * _stride + j]; }
+    
+    T* data() { return _items.data(); }
+    T const* data() const { return _items.data(); }
+    
+    // keeps the top left corner, new cells get value
+    void resize(std::size_t rows, std::size_t cols, T const& value = T {}) {
+        Matrix2D grown (rows, cols, value);
+        for(auto i = 0u; i < std::min(rows, _rows); ++i) {
+            std::copy((*this)[i].begin(), (*this)[i].begin() + std::min(cols, _cols), grown[i].begin());
+        }
+        *this = std::move(grown);
+    }
+    
+    std::vector<std::vector<T>> to_vectors() const {
+        std::vector<std::vector<T>> ret;
+        for(auto i = 0u; i < _rows; ++i) {
+            ret.emplace_back((*this)[i].begin(), (*this)[i].end());
+        }
+        return ret;
+    }
+    
+    bool operator ==(Matrix2D const& o) const {
+        if(_rows != o._rows || _cols != o._cols) return false;
+        
+        for(auto i = 0u; i < _rows; ++i) {
+            if(!std::equal((*this)[i].begin(), (*this)[i].end(), o[i].begin())) return false;
+        }
+        return true;
+    }
+    
+    bool operator !=(Matrix2D const& o) const {
+        return !(*this == o);
+    }
+    
+    friend bool operator ==(Matrix2D const& m, std::vector<std::vector<T>> const& v) {
+        if(m._rows != v.size()) return false;
+        
+        for(auto i = 0u; i < m._rows; ++i) {
+            if(v[i].size() != m._cols) return false;
+            if(!std::equal(m[i].begin(), m[i].end(), v[i].begin())) return false;
+        }
+        return true;
+    }
+    
+    friend bool operator ==(std::vector<std::vector<T>> const& v, Matrix2D const& m) {
+        return m == v;
+    }
+
+private:
+    std::size_t    _rows = 0;
+    std::size_t    _cols = 0;
+    std::size_t    _stride = 0;
+    std::vector<T> _items;
+};
+
+#endif
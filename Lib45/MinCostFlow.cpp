@@ -0,0 +1,141 @@
+#include "MinCostFlow.h"
+#include "NetworkSimplex.h"
+#include <Fraction.h>
+#include <Trace.h>
+
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <type_traits>
+
+template <typename Cost, typename Flow>
+int BasicMinCostFlow<Cost, Flow>::add_node(Flow supply) {
+    _supply.push_back(supply);
+    return nodes_num() - 1;
+}
+
+template <typename Cost, typename Flow>
+int BasicMinCostFlow<Cost, Flow>::add_arc(int source, int target, Cost cost) {
+    if(source < 0 || source >= nodes_num() || target < 0 || target >= nodes_num()) return -1;
+    
+    _source.push_back(source);
+    _target.push_back(target);
+    _cost.push_back(cost);
+    _cap.push_back(Flow {});
+    _capped.push_back(false);
+    return arcs_num() - 1;
+}
+
+template <typename Cost, typename Flow>
+bool BasicMinCostFlow<Cost, Flow>::set_capacity(int arc, Flow capacity) {
+    if(arc < 0 || arc >= arcs_num() || capacity < Flow {}) return false;
+    
+    _cap[arc] = capacity;
+    _capped[arc] = true;
+    return true;
+}
+
+template <typename Cost, typename Flow>
+int BasicMinCostFlow<Cost, Flow>::nodes_num() const {
+    return _supply.size();
+}
+
+template <typename Cost, typename Flow>
+int BasicMinCostFlow<Cost, Flow>::arcs_num() const {
+    return _source.size();
+}
+
+// how far a floating balance can be off zero by rounding alone
+template <typename Flow>
+static Flow tolerance(Flow const& total, std::true_type) {
+    return total * std::sqrt(std::numeric_limits<Flow>::epsilon());
+}
+
+template <typename Flow>
+static Flow tolerance(Flow const&, std::false_type) {
+    return Flow {};
+}
+
+// the imbalance goes to one more node, with a free arc from every source
+// if there's too much supply or to every sink if there's too little;
+// they follow the arcs that were added and aren't in the result
+template <typename Cost, typename Flow>
+auto BasicMinCostFlow<Cost, Flow>::solve(Trace* trace) const -> Result {
+    auto nodesNum = nodes_num();
+    auto arcsNum = arcs_num();
+    auto balance = std::accumulate(_supply.begin(), _supply.end(), Flow {});
+    auto dummy = nodesNum;
+    
+    Flow total {};
+    for(auto const& supply : _supply) {
+        if(supply > Flow {}) total += supply;
+    }
+    auto off = tolerance(total, std::is_floating_point<Flow> {});
+    if(balance <= off && -balance <= off) balance = Flow {};
+    
+    BasicNetworkSimplex<Cost, Flow> ns (nodesNum + 1);
+    for(int u = 0; u < nodesNum; ++u) {
+        ns.set_supply(u, _supply[u]);
+    }
+    ns.set_supply(dummy, -balance);
+    
+    for(int e = 0; e < arcsNum; ++e) {
+        ns.add_arc(_source[e], _target[e], _cost[e]);
+        if(_capped[e]) ns.set_capacity(e, _cap[e]);
+    }
+    for(int u = 0; u < nodesNum; ++u) {
+        if(balance > Flow {} && _supply[u] > Flow {}) ns.add_arc(u, dummy, Cost {});
+        if(balance < Flow {} && _supply[u] < Flow {}) ns.add_arc(dummy, u, Cost {});
+    }
+    
+    Result ret;
+    ret.surplus = balance > Flow {} ? balance : Flow {};
+    ret.unmet = balance < Flow {} ? -balance : Flow {};
+    switch(ns.run(trace)) {
+    case BasicNetworkSimplex<Cost, Flow>::Status::optimal:
+        ret.status = Status::optimal;
+        break;
+    case BasicNetworkSimplex<Cost, Flow>::Status::infeasible:
+        ret.status = Status::infeasible;
+        return ret;
+    case BasicNetworkSimplex<Cost, Flow>::Status::unbounded:
+        ret.status = Status::unbounded;
+        return ret;
+    }
+    
+    ret.potentials.reserve(nodesNum);
+    for(int u = 0; u < nodesNum; ++u) {
+        ret.potentials.push_back(ns.potential(u));
+    }
+    
+    ret.X.reserve(arcsNum);
+    ret.eps.reserve(arcsNum);
+    ret.upper.reserve(arcsNum);
+    ret.D.reserve(arcsNum);
+    for(int e = 0; e < arcsNum; ++e) {
+        ret.X.push_back(ns.flow(e));
+        ret.eps.push_back(ns.basic(e) && ret.X.back() == Flow {});
+        ret.upper.push_back(ns.saturated(e));
+        ret.D.push_back(_cost[e] + ret.potentials[_source[e]] - ret.potentials[_target[e]]);
+        ret.W += _cost[e] * ret.X.back();
+    }
+    
+    return ret;
+}
+
+// no arc would lower the cost: the ones pricing below zero are full,
+// the ones pricing above it are empty
+template <typename Cost, typename Flow>
+bool BasicMinCostFlow<Cost, Flow>::Result::valid() const {
+    if(status != Status::optimal) return false;
+    
+    for(auto e = 0u; e < D.size(); ++e) {
+        if(D[e] < Cost {} && !upper[e]) return false;
+        if(D[e] > Cost {} && X[e] != Flow {}) return false;
+    }
+    return true;
+}
+
+template class BasicMinCostFlow<long long>;
+template class BasicMinCostFlow<double>;
+template class BasicMinCostFlow<Fraction>;
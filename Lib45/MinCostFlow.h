@@ -0,0 +1,73 @@
+#ifndef MINCOSTFLOW_H_INCLUDED
+#define MINCOSTFLOW_H_INCLUDED
+
+#include <vector>
+
+class Trace;
+
+// min-cost flow over a directed graph: nodes with a supply, negative for
+// a demand, and arcs with a cost and maybe a capacity; the transport
+// problem is the graph with arcs only from sources to sinks, warehouses
+// in between are nodes without a supply.
+// The supplies don't have to balance, what's over the demand stays at
+// its sources and what's short of it goes unmet, both at no cost and
+// both told in the result; double supplies balance within rounding.
+// Solved by the network simplex; instantiated for long long, double and
+// Fraction
+template <typename Cost, typename Flow = Cost>
+class BasicMinCostFlow {
+public:
+    using Total = decltype(Cost {} * Flow {});
+    
+    enum class Status {
+        optimal, infeasible, unbounded
+    };
+    
+    struct Result;
+    
+    // nodes and arcs are numbered from 0 in the order they're added
+    int add_node(Flow supply = Flow {});
+    
+    // -1 if either end isn't a node
+    int add_arc(int source, int target, Cost cost);
+    
+    // arcs carry any flow until given a capacity, false for an arc
+    // that isn't there or a negative capacity
+    bool set_capacity(int arc, Flow capacity);
+    
+    int nodes_num() const;
+    int arcs_num() const;
+    
+    Result solve(Trace* trace = nullptr) const;
+
+private:
+    std::vector<Flow> _supply;
+    std::vector<int>  _source;
+    std::vector<int>  _target;
+    std::vector<Cost> _cost;
+    std::vector<Flow> _cap;
+    std::vector<char> _capped;
+};
+
+using MinCostFlow = BasicMinCostFlow<long long>;
+
+// by arc, empty unless the status is optimal; D holds the reduced costs,
+// eps marks the basic arcs without flow and upper the ones out of the
+// basis at their capacity. At most one of surplus and unmet isn't zero,
+// whatever the status
+template <typename Cost, typename Flow>
+struct BasicMinCostFlow<Cost, Flow>::Result {
+    Status            status = Status::infeasible;
+    Flow              surplus {}; // supply over the demand, left at the sources
+    Flow              unmet {};   // demand over the supply
+    std::vector<Flow> X;
+    std::vector<char> eps;
+    std::vector<char> upper;
+    std::vector<Cost> D;
+    std::vector<Cost> potentials; // by node
+    Total W {};
+    
+    bool valid() const;
+};
+
+#endif
@@ -0,0 +1,386 @@
+#include "NetworkSimplex.h"
+#include <Fraction.h>
+#include <Trace.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <type_traits>
+
+static constexpr int UP = 1;
+static constexpr int DOWN = -1;
+
+// sums of floating quantities are off by rounding, this much of the total
+// is taken for it; exact types have none
+template <typename Flow>
+static Flow tolerance(Flow const& total, std::true_type) {
+    return total * std::sqrt(std::numeric_limits<Flow>::epsilon());
+}
+
+template <typename Flow>
+static Flow tolerance(Flow const&, std::false_type) {
+    return Flow {};
+}
+
+template <typename Cost, typename Flow>
+BasicNetworkSimplex<Cost, Flow>::BasicNetworkSimplex(int nodesNum)
+: _nodesNum {nodesNum}
+, _supply   (nodesNum, 0)
+{}
+
+template <typename Cost, typename Flow>
+int BasicNetworkSimplex<Cost, Flow>::add_arc(int source, int target, Cost cost) {
+    assert(source >= 0 && source < _nodesNum);
+    assert(target >= 0 && target < _nodesNum);
+    
+    _source.resize(_arcsNum);
+    _target.resize(_arcsNum);
+    _cost.resize(_arcsNum);
+    _cap.resize(_arcsNum);
+    _capped.resize(_arcsNum);
+    
+    _source.push_back(source);
+    _target.push_back(target);
+    _cost.push_back(cost);
+    _cap.push_back(Flow {});
+    _capped.push_back(false);
+    return _arcsNum++;
+}
+
+template <typename Cost, typename Flow>
+void BasicNetworkSimplex<Cost, Flow>::set_capacity(int arc, Flow capacity) {
+    assert(arc >= 0 && arc < _arcsNum);
+    assert(capacity >= Flow {});
+    
+    _cap[arc] = capacity;
+    _capped[arc] = true;
+}
+
+template <typename Cost, typename Flow>
+void BasicNetworkSimplex<Cost, Flow>::set_supply(int node, Flow supply) {
+    _supply[node] = supply;
+}
+
+template <typename Cost, typename Flow>
+auto BasicNetworkSimplex<Cost, Flow>::run(Trace* trace) -> Status {
+    Trace::Span span {trace, "network_simplex"};
+    
+    _pivots = 0;
+    
+    Flow total {};
+    for(auto const& s : _supply) {
+        if(s > Flow {}) total += s;
+    }
+    _tolerance = tolerance(total, std::is_floating_point<Flow> {});
+    if(!zero(std::accumulate(_supply.begin(), _supply.end(), Flow {}))) {
+        return Status::infeasible;
+    }
+    
+    {
+        Trace::Span span {trace, "init"};
+        init();
+    }
+    
+    for(int iteration = 1; ; ++iteration) {
+        Trace::Span iterationSpan {trace, "iteration", iteration};
+        
+        int in;
+        {
+            Trace::Span span {trace, "pricing"};
+            in = find_entering();
+        }
+        if(in < 0) break;
+        
+        Trace::Span span {trace, "pivot"};
+        if(!pivot(in)) return Status::unbounded;
+        ++_pivots;
+    }
+    
+    // flow left on an artificial arc has nowhere real to go
+    for(int u = 0; u < _nodesNum; ++u) {
+        if(!zero(_flow[_arcsNum + u])) return Status::infeasible;
+    }
+    return Status::optimal;
+}
+
+template <typename Cost, typename Flow>
+Flow BasicNetworkSimplex<Cost, Flow>::flow(int arc) const {
+    return _flow[arc];
+}
+
+template <typename Cost, typename Flow>
+bool BasicNetworkSimplex<Cost, Flow>::basic(int arc) const {
+    return _state[arc] == State::tree;
+}
+
+template <typename Cost, typename Flow>
+bool BasicNetworkSimplex<Cost, Flow>::saturated(int arc) const {
+    return _state[arc] == State::upper;
+}
+
+template <typename Cost, typename Flow>
+Cost BasicNetworkSimplex<Cost, Flow>::potential(int node) const {
+    return _pi[node];
+}
+
+template <typename Cost, typename Flow>
+auto BasicNetworkSimplex<Cost, Flow>::total_cost() const -> decltype(Cost {} * Flow {}) {
+    decltype(Cost {} * Flow {}) ret {};
+    for(int e = 0; e < _arcsNum; ++e) {
+        ret += _cost[e] * _flow[e];
+    }
+    return ret;
+}
+
+template <typename Cost, typename Flow>
+unsigned long BasicNetworkSimplex<Cost, Flow>::pivots() const {
+    return _pivots;
+}
+
+// every node hangs on the root by its own artificial arc, which carries
+// its supply; zero supplies point away from the root, so the tree starts
+// strongly feasible and the leaving arc rule keeps it that way
+template <typename Cost, typename Flow>
+void BasicNetworkSimplex<Cost, Flow>::init() {
+    auto arcsNum = _arcsNum + _nodesNum;
+    auto root = _nodesNum;
+    
+    _source.resize(arcsNum);
+    _target.resize(arcsNum);
+    _cost.resize(arcsNum);
+    _cap.resize(arcsNum, Flow {});
+    _capped.resize(arcsNum, false);
+    _flow.assign(arcsNum, Flow {});
+    _state.assign(arcsNum, State::lower);
+    
+    Cost maxCost {};
+    for(int e = 0; e < _arcsNum; ++e) {
+        maxCost = std::max(maxCost, _cost[e] < Cost {} ? -_cost[e] : _cost[e]);
+    }
+    _artificialCost = (maxCost + Cost(1)) * Cost(_nodesNum + 1);
+    
+    _parent.assign(root + 1, root);
+    _pred.assign(root + 1, -1);
+    _predDir.assign(root + 1, UP);
+    _depth.assign(root + 1, 1);
+    _thread.resize(root + 1);
+    _revThread.resize(root + 1);
+    _pi.assign(root + 1, Cost {});
+    
+    _parent[root] = -1;
+    _depth[root] = 0;
+    for(int u = 0; u <= root; ++u) {
+        _thread[u] = u == root ? 0 : u + 1;
+        _revThread[_thread[u]] = u;
+    }
+    
+    for(int u = 0; u < root; ++u) {
+        auto e = _arcsNum + u;
+        _pred[u] = e;
+        _state[e] = State::tree;
+        _cost[e] = _artificialCost;
+        
+        if(_supply[u] > Flow {}) {
+            _source[e] = u;
+            _target[e] = root;
+            _flow[e] = _supply[u];
+            _predDir[u] = UP;
+            _pi[u] = -_artificialCost;
+        }
+        else {
+            _source[e] = root;
+            _target[e] = u;
+            _flow[e] = -_supply[u];
+            _predDir[u] = DOWN;
+            _pi[u] = _artificialCost;
+        }
+    }
+    
+    _blockSize = std::max(10, static_cast<int>(std::ceil(std::sqrt(_arcsNum))));
+    _nextArc = 0;
+    
+    _around.assign(root + 1, {});
+}
+
+// the most negative reduced cost within the first block that has one,
+// the search goes on from where the previous one stopped; arcs at their
+// upper bound count with the sign turned, their flow can only go down
+template <typename Cost, typename Flow>
+int BasicNetworkSimplex<Cost, Flow>::find_entering() {
+    Cost minCost {};
+    int in = -1;
+    int count = _blockSize;
+    
+    for(int k = 0, e = _nextArc; k < _arcsNum; ++k) {
+        if(_state[e] != State::tree) {
+            auto c = _cost[e] + _pi[_source[e]] - _pi[_target[e]];
+            if(_state[e] == State::upper) c = -c;
+            if(c < minCost) {
+                minCost = c;
+                in = e;
+            }
+        }
+        
+        if(++e == _arcsNum) e = 0;
+        if(--count == 0) {
+            if(in >= 0) {
+                _nextArc = e;
+                return in;
+            }
+            count = _blockSize;
+        }
+    }
+    
+    return in;
+}
+
+template <typename Cost, typename Flow>
+bool BasicNetworkSimplex<Cost, Flow>::pivot(int in) {
+    // the flow goes along the entering arc and back through the tree,
+    // against the arc if it enters from its upper bound
+    auto fromUpper = _state[in] == State::upper;
+    auto first = fromUpper ? _target[in] : _source[in];
+    auto second = fromUpper ? _source[in] : _target[in];
+    
+    auto u = first;
+    auto v = second;
+    while(u != v) {
+        if(_depth[u] >= _depth[v]) u = _parent[u];
+        if(_depth[v] > _depth[u]) v = _parent[v];
+    }
+    auto join = u;
+    
+    // how much more an arc takes in the cycle's direction, arcs without
+    // a capacity only limit it when their flow goes down
+    auto room = [this](int e, bool down, Flow& out) {
+        if(down) out = _flow[e];
+        else if(_capped[e]) out = _cap[e] - _flow[e];
+        else return false;
+        return true;
+    };
+    
+    // the last blocking arc in the cycle's direction leaves, counting
+    // from the join, which keeps the zero flow arcs pointing downwards;
+    // none found leaves the entering arc to go over to its other bound
+    Flow delta {};
+    auto limited = room(in, fromUpper, delta);
+    auto uOut = -1;
+    auto onFirst = false;
+    
+    Flow d;
+    for(u = first; u != join; u = _parent[u]) {
+        if(room(_pred[u], _predDir[u] == UP, d) && (!limited || d < delta)) {
+            delta = d;
+            limited = true;
+            uOut = u;
+            onFirst = true;
+        }
+    }
+    for(u = second; u != join; u = _parent[u]) {
+        if(room(_pred[u], _predDir[u] == DOWN, d) && (!limited || d <= delta)) {
+            delta = d;
+            limited = true;
+            uOut = u;
+            onFirst = false;
+        }
+    }
+    if(!limited) return false;
+    
+    if(delta > Flow {}) {
+        if(fromUpper) _flow[in] -= delta;
+        else _flow[in] += delta;
+        for(u = first; u != join; u = _parent[u]) {
+            if(_predDir[u] == UP) _flow[_pred[u]] -= delta;
+            else _flow[_pred[u]] += delta;
+        }
+        for(u = second; u != join; u = _parent[u]) {
+            if(_predDir[u] == UP) _flow[_pred[u]] += delta;
+            else _flow[_pred[u]] -= delta;
+        }
+    }
+    
+    if(uOut < 0) {
+        _state[in] = fromUpper ? State::lower : State::upper;
+        return true;
+    }
+    
+    // the leaving arc goes to the bound it's at, rounding is dropped
+    auto out = _pred[uOut];
+    _state[in] = State::tree;
+    _state[out] = zero(_flow[out]) ? State::lower : State::upper;
+    _flow[out] = _state[out] == State::lower ? Flow {} : _cap[out];
+    
+    auto uIn = onFirst ? first : second;
+    auto vIn = onFirst ? second : first;
+    
+    // the moved subtree is shifted so the entering arc prices to zero
+    auto reduced = _cost[in] + _pi[_source[in]] - _pi[_target[in]];
+    rehang(uOut, uIn, vIn, in, uIn == _source[in] ? -reduced : reduced);
+    
+    return true;
+}
+
+// cuts the subtree of uOut off its parent and hangs it on vIn by the
+// entering arc, with uIn as its new top; costs O(size of the subtree)
+template <typename Cost, typename Flow>
+void BasicNetworkSimplex<Cost, Flow>::rehang(int uOut, int uIn, int vIn, int in, Cost sigma) {
+    auto before = _revThread[uOut];
+    auto after = uOut;
+    do {
+        if(after != uOut) {
+            auto p = _parent[after];
+            _around[after].emplace_back(p, _pred[after]);
+            _around[p].emplace_back(after, _pred[after]);
+        }
+        after = _thread[after];
+    } while(_depth[after] > _depth[uOut]);
+    
+    _thread[before] = after;
+    _revThread[after] = before;
+    
+    _parent[uIn] = vIn;
+    _pred[uIn] = in;
+    _predDir[uIn] = _source[in] == uIn ? UP : DOWN;
+    _depth[uIn] = _depth[vIn] + 1;
+    
+    // a new preorder of the subtree goes in right after vIn
+    auto last = vIn;
+    auto next = _thread[vIn];
+    
+    _stack.assign(1, uIn);
+    while(!_stack.empty()) {
+        auto x = _stack.back();
+        _stack.pop_back();
+        
+        _thread[last] = x;
+        _revThread[x] = last;
+        last = x;
+        _pi[x] += sigma;
+        
+        for(auto const& link : _around[x]) {
+            auto y = link.first;
+            if(y == _parent[x]) continue;
+            
+            _parent[y] = x;
+            _pred[y] = link.second;
+            _predDir[y] = _source[link.second] == y ? UP : DOWN;
+            _depth[y] = _depth[x] + 1;
+            _stack.push_back(y);
+        }
+        _around[x].clear();
+    }
+    
+    _thread[last] = next;
+    _revThread[next] = last;
+}
+
+template <typename Cost, typename Flow>
+bool BasicNetworkSimplex<Cost, Flow>::zero(Flow const& flow) const {
+    return flow <= _tolerance && -flow <= _tolerance;
+}
+
+template class BasicNetworkSimplex<long long>;
+template class BasicNetworkSimplex<double>;
+template class BasicNetworkSimplex<Fraction>;
@@ -0,0 +1,89 @@
+#ifndef NETWORKSIMPLEX_H_INCLUDED
+#define NETWORKSIMPLEX_H_INCLUDED
+
+#include <utility>
+#include <vector>
+
+class Trace;
+
+// min-cost flow over a directed graph by the primal network simplex;
+// the basis is a spanning tree hung on an artificial root and kept in
+// parent/thread/depth arrays, entering arcs are priced block by block;
+// instantiated for long long, double and Fraction; double flows within a
+// rounding error of the total supply count as balanced and as zero
+template <typename Cost, typename Flow = Cost>
+class BasicNetworkSimplex {
+public:
+    enum class Status {
+        optimal, infeasible, unbounded
+    };
+    
+    explicit BasicNetworkSimplex(int nodesNum);
+    
+    // returns the index of the arc, they're numbered from 0 in order
+    int add_arc(int source, int target, Cost cost);
+    
+    // arcs carry any flow until given a capacity
+    void set_capacity(int arc, Flow capacity);
+    
+    // positive for sources, negative for sinks
+    void set_supply(int node, Flow supply);
+    
+    Status run(Trace* trace = nullptr);
+    
+    Flow flow(int arc) const;
+    bool basic(int arc) const;
+    bool saturated(int arc) const; // out of the basis at its capacity
+    Cost potential(int node) const;
+    decltype(Cost {} * Flow {}) total_cost() const;
+    unsigned long pivots() const;
+
+private:
+    enum class State : char {
+        lower, tree, upper
+    };
+    
+    void init();
+    int find_entering();
+    bool pivot(int in);
+    void rehang(int uOut, int uIn, int vIn, int in, Cost sigma);
+    bool zero(Flow const& flow) const;
+    
+    int  _nodesNum;
+    int  _arcsNum = 0;
+    Cost _artificialCost {};
+    Flow _tolerance {}; // what counts as no flow, 0 unless Flow is floating
+    
+    std::vector<Flow> _supply;
+    
+    // arcs, the artificial ones follow the added
+    std::vector<int>   _source;
+    std::vector<int>   _target;
+    std::vector<Cost>  _cost;
+    std::vector<Flow>  _flow;
+    std::vector<Flow>  _cap;
+    std::vector<char>  _capped;
+    std::vector<State> _state;
+    
+    // tree, the root is the last node
+    std::vector<int>   _parent;
+    std::vector<int>   _pred;    // arc to the parent
+    std::vector<int>   _predDir; // 1 if it goes to the parent, -1 if from
+    std::vector<int>   _depth;
+    std::vector<int>   _thread;  // preorder walk, each subtree is a run of it
+    std::vector<int>   _revThread;
+    std::vector<Cost>  _pi;
+    
+    int _blockSize = 0;
+    int _nextArc = 0;
+    
+    unsigned long _pivots = 0;
+    
+    // reused by rehang
+    std::vector<std::vector<std::pair<int, int>>> _around;
+    std::vector<int> _stack;
+};
+
+using NetworkSimplex = BasicNetworkSimplex<long long>;
+
+#endif
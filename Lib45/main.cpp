@@ -1,10 +1,299 @@
+#include "Auction.h"
 #include "BalanceMatrix.h"
+#include "Kernels.h"
+#include "MinCostFlow.h"
+#include "NetworkSimplex.h"
+#include <Fraction.h>
+#include <Trace.h>
 
 #include <UnitTest++/UnitTest++.h>
+#include <algorithm>
 #include <iostream>
+#include <random>
 
 using std::vector;
 
+SUITE(Matrix2D) {
+    TEST(Layout) {
+        Matrix2D<int> m (2, 3, 7);
+        CHECK(m.rows() == 2);
+        CHECK(m.cols() == 3);
+        CHECK(m.stride() >= 3);
+        
+        m[1][2] = 5;
+        CHECK(m(1, 2) == 5);
+        CHECK(m.data()[m.stride() + 2] == 5);
+        CHECK(m[1].size() == 3);
+        
+        CHECK((m == vector<vector<int>> {{7, 7, 7}, {7, 7, 5}}));
+        CHECK((m.to_vectors() == vector<vector<int>> {{7, 7, 7}, {7, 7, 5}}));
+        CHECK(!(m == vector<vector<int>> {{7, 7, 7}}));
+        
+        m.resize(3, 2, 1);
+        CHECK((m == vector<vector<int>> {{7, 7}, {7, 7}, {1, 1}}));
+        CHECK(m == Matrix2D<int>(vector<vector<int>> {{7, 7}, {7, 7}, {1, 1}}));
+        CHECK_THROW(Matrix2D<int>(vector<vector<int>> {{7, 7}, {7}}), std::invalid_argument);
+        
+        Matrix2D<int> narrow (vector<vector<int>> {{}, {}});
+        CHECK(narrow.rows() == 2 && narrow.empty());
+        CHECK(narrow[1].size() == 0 && narrow[1].begin() == narrow[1].end());
+        narrow.resize(2, 1, 3);
+        CHECK((narrow == vector<vector<int>> {{3}, {3}}));
+    }
+}
+
+SUITE(Kernels) {
+    TEST(SameAsScalar) {
+        std::mt19937 gen {7};
+        std::uniform_int_distribution<int> value {-50, 50};
+        std::uniform_int_distribution<int> bit {0, 1};
+        
+        // lengths around the vector width check the tails
+        for(std::size_t n = 0; n < 70; ++n) {
+            vector<int> costs (n), V (n), mask (n), row (n);
+            for(auto j = 0u; j < n; ++j) {
+                costs[j] = value(gen);
+                V[j] = value(gen);
+                mask[j] = bit(gen) ? ~0 : 0;
+                row[j] = value(gen) / 10; // repeats to check the ties
+            }
+            
+            vector<int> out (n), expected (n);
+            kernels::price_row(out.data(), costs.data(), V.data(), 3, n);
+            kernels::scalar::price_row(expected.data(), costs.data(), V.data(), 3, n);
+            CHECK(out == expected);
+            
+            out = expected = costs;
+            kernels::shift_row(out.data(), mask.data(), -7, n);
+            kernels::scalar::shift_row(expected.data(), mask.data(), -7, n);
+            CHECK(out == expected);
+            
+            CHECK_EQUAL(kernels::scalar::argmin(row.data(), n), kernels::argmin(row.data(), n));
+        }
+    }
+}
+
+SUITE(NetworkSimplex) {
+    TEST(Transshipment) {
+        // two sources and two sinks, mostly served through a warehouse
+        NetworkSimplex ns (5);
+        ns.set_supply(0, 5);
+        ns.set_supply(1, 3);
+        ns.set_supply(3, -4);
+        ns.set_supply(4, -4);
+        
+        ns.add_arc(0, 2, 1);
+        ns.add_arc(1, 2, 2);
+        ns.add_arc(2, 3, 1);
+        ns.add_arc(2, 4, 2);
+        ns.add_arc(0, 3, 5);
+        ns.add_arc(1, 4, 2);
+        
+        CHECK(ns.run() == NetworkSimplex::Status::optimal);
+        CHECK(ns.total_cost() == 17);
+        CHECK(ns.flow(0) == 5);
+        CHECK(ns.flow(1) == 0);
+        CHECK(ns.flow(2) == 4);
+        CHECK(ns.flow(3) == 1);
+        CHECK(ns.flow(4) == 0);
+        CHECK(ns.flow(5) == 3);
+    }
+    
+    TEST(Infeasible) {
+        NetworkSimplex unbalanced (2);
+        unbalanced.set_supply(0, 2);
+        unbalanced.set_supply(1, -1);
+        unbalanced.add_arc(0, 1, 1);
+        CHECK(unbalanced.run() == NetworkSimplex::Status::infeasible);
+        
+        NetworkSimplex unreachable (3);
+        unreachable.set_supply(0, 1);
+        unreachable.set_supply(2, -1);
+        unreachable.add_arc(0, 1, 1);
+        unreachable.add_arc(2, 1, 1);
+        CHECK(unreachable.run() == NetworkSimplex::Status::infeasible);
+    }
+    
+    TEST(Capacities) {
+        // the warehouse takes only so much, the rest goes direct
+        NetworkSimplex ns (5);
+        ns.set_supply(0, 5);
+        ns.set_supply(1, 3);
+        ns.set_supply(3, -4);
+        ns.set_supply(4, -4);
+        
+        ns.add_arc(0, 2, 1);
+        ns.add_arc(1, 2, 2);
+        ns.add_arc(2, 3, 1);
+        ns.add_arc(2, 4, 2);
+        ns.add_arc(0, 3, 5);
+        ns.add_arc(1, 4, 2);
+        ns.set_capacity(0, 3);
+        
+        CHECK(ns.run() == NetworkSimplex::Status::optimal);
+        CHECK(ns.total_cost() == 23);
+        CHECK(ns.flow(0) == 3);
+        CHECK(ns.saturated(0));
+        CHECK(ns.flow(4) == 2);
+        
+        // a closed arc is as good as none
+        NetworkSimplex closed (2);
+        closed.set_supply(0, 1);
+        closed.set_supply(1, -1);
+        closed.add_arc(0, 1, 1);
+        closed.set_capacity(0, 0);
+        CHECK(closed.run() == NetworkSimplex::Status::infeasible);
+    }
+}
+
+SUITE(Auction) {
+    TEST(Plan) {
+        Matrix2D<long long> costs ({
+            {5, 8, 4, 4},
+            {1, 2, 3, 8},
+            {4, 7, 6, 1}
+        });
+        std::vector<long long> prods {80, 45, 60};
+        std::vector<long long> consums {45, 60, 40, 40};
+        
+        BalanceMatrix reference;
+        reference.set({
+            {5, 8, 4, 4, 80},
+            {1, 2, 3, 8, 45},
+            {4, 7, 6, 1, 60},
+            {45, 60, 40, 40}
+        });
+        
+        Auction one {1};
+        auto plan = one.solve(costs, prods, consums);
+        CHECK(plan.rows() == 3 && plan.cols() == 4);
+        CHECK(one.rounds() > 0);
+        
+        long long W = 0;
+        std::vector<long long> sent (plan.rows(), 0);
+        std::vector<long long> got (plan.cols(), 0);
+        for(auto i = 0u; i < plan.rows(); ++i) {
+            for(auto j = 0u; j < plan.cols(); ++j) {
+                CHECK(plan[i][j] >= 0);
+                sent[i] += plan[i][j];
+                got[j] += plan[i][j];
+                W += plan[i][j] * costs[i][j];
+            }
+        }
+        CHECK(sent == prods);
+        CHECK(got == consums);
+        CHECK(W == reference.solve(BalanceMatrix::Meth::Network).back().W);
+        
+        // the rounds come out the same however many settle them
+        Auction two {2};
+        CHECK(two.threads_num() == 2);
+        CHECK(two.solve(costs, prods, consums) == plan);
+        CHECK(two.rounds() == one.rounds());
+        
+        CHECK(one.solve(costs, prods, {45, 60, 40, 41}).empty());
+    }
+    
+    TEST(ZeroDemand) {
+        // nobody bids for a sink that wants nothing
+        Matrix2D<long long> costs ({
+            {1, 2},
+            {3, 4}
+        });
+        Auction auction {1};
+        auto plan = auction.solve(costs, {5, 5}, {10, 0});
+        CHECK(plan == std::vector<std::vector<long long>>({{5, 0}, {5, 0}}));
+    }
+}
+
+SUITE(MinCostFlow) {
+    TEST(Warehouse) {
+        // two plants, a warehouse and two customers who want less than
+        // is made, the rest stays at the plants
+        MinCostFlow flows;
+        auto plant1 = flows.add_node(5);
+        auto plant2 = flows.add_node(3);
+        auto warehouse = flows.add_node();
+        auto customer1 = flows.add_node(-4);
+        auto customer2 = flows.add_node(-2);
+        
+        flows.add_arc(plant1, warehouse, 1);
+        flows.add_arc(plant2, warehouse, 2);
+        flows.add_arc(warehouse, customer1, 1);
+        flows.add_arc(warehouse, customer2, 2);
+        flows.add_arc(plant1, customer1, 5);
+        flows.add_arc(plant2, customer2, 2);
+        CHECK(flows.nodes_num() == 5);
+        CHECK(flows.arcs_num() == 6);
+        
+        auto result = flows.solve();
+        CHECK(result.status == MinCostFlow::Status::optimal);
+        CHECK(result.valid());
+        CHECK(result.W == 12);
+        CHECK(result.X == std::vector<long long>({4, 0, 4, 0, 0, 2}));
+        CHECK(result.surplus == 2 && result.unmet == 0);
+        
+        // the warehouse takes only so much from the first plant,
+        // the second sends more through it
+        CHECK(flows.set_capacity(0, 3));
+        result = flows.solve();
+        CHECK(result.valid());
+        CHECK(result.W == 13);
+        CHECK(result.X == std::vector<long long>({3, 1, 4, 0, 0, 2}));
+        CHECK(result.upper[0]);
+    }
+    
+    TEST(Status) {
+        MinCostFlow flows;
+        auto a = flows.add_node();
+        auto b = flows.add_node();
+        CHECK(flows.add_arc(a, 2, 1) == -1);
+        
+        // a cycle that pays for going round it
+        flows.add_arc(a, b, -1);
+        flows.add_arc(b, a, -1);
+        CHECK(flows.solve().status == MinCostFlow::Status::unbounded);
+        
+        CHECK(!flows.set_capacity(2, 1));
+        CHECK(!flows.set_capacity(0, -1));
+        CHECK(flows.set_capacity(0, 3));
+        auto result = flows.solve();
+        CHECK(result.valid());
+        CHECK(result.W == -6);
+        
+        // the demand is only short of what's made, it can't be cut off
+        MinCostFlow cut;
+        auto from = cut.add_node(2);
+        auto to = cut.add_node(-2);
+        cut.add_arc(from, to, 1);
+        cut.set_capacity(0, 1);
+        CHECK(cut.solve().status == MinCostFlow::Status::infeasible);
+        
+        MinCostFlow lacking;
+        lacking.add_node(2);
+        lacking.add_node(-3);
+        lacking.add_arc(0, 1, 4);
+        result = lacking.solve();
+        CHECK(result.valid());
+        CHECK(result.W == 8);
+        CHECK(result.surplus == 0 && result.unmet == 1);
+    }
+    
+    TEST(Rounding) {
+        // 0.1 + 0.2 isn't 0.3 in doubles, it's balanced all the same
+        BasicMinCostFlow<double> flows;
+        flows.add_node(0.1);
+        flows.add_node(0.2);
+        flows.add_node(-0.3);
+        flows.add_arc(0, 2, 1);
+        flows.add_arc(1, 2, 2);
+        
+        auto result = flows.solve();
+        CHECK(result.status == BasicMinCostFlow<double>::Status::optimal);
+        CHECK_CLOSE(result.W, 0.5, 1e-9);
+        CHECK(result.surplus == 0 && result.unmet == 0);
+    }
+}
+
 SUITE(BalanceMatrix) {
     TEST(Initialization) {
         BalanceMatrix m;
@@ -172,6 +461,29 @@ SUITE(BalanceMatrix) {
         }));
     }
     
+    TEST_FIXTURE(MatricesFixture, VogelMethod) {
+        auto key = m[0].get_key0_by_vogel_method();
+        CHECK((key == vector<vector<int>> {
+            {25, 15, 40,  0},
+            { 0, 45,  0,  0},
+            {20,  0,  0, 40},
+            { 0,  0, 30,  0}
+        }));
+        
+        key = m[4].get_key0_by_vogel_method();
+        CHECK((key == vector<vector<int>> {
+            {0, 3, 1, 7},
+            {5, 6, 0, 0},
+            {0, 0, 8, 0}
+        }));
+        
+        for(auto& matrix : m) {
+            auto lastStepVogel = matrix.solve(BalanceMatrix::Meth::Vogel).back();
+            CHECK(lastStepVogel.valid());
+            CHECK(lastStepVogel.W == matrix.solve(BalanceMatrix::Meth::NW).back().W);
+        }
+    }
+    
     TEST_FIXTURE(MatricesFixture, PotentialMethod) {
         auto lastStepNW = m[0].solve(BalanceMatrix::Meth::NW).back();
         auto lastStepMin = m[0].solve(BalanceMatrix::Meth::Min).back();
@@ -198,10 +510,17 @@ SUITE(BalanceMatrix) {
         CHECK((lastStepNW.X == vector<vector<int>> {
             { 0, 10,  0,  0},
             { 0,  0,  0, 20},
-            {40,  0, 10, -1},
+            {40,  0, 10,  0},
             { 0, 20, 10,  0},
             { 0,  0,  0, 20}
         }));
+        CHECK((lastStepNW.eps == vector<vector<char>> {
+            {0, 0, 0, 0},
+            {0, 0, 0, 0},
+            {0, 0, 0, 1},
+            {0, 0, 0, 0},
+            {0, 0, 0, 0}
+        }));
         CHECK((lastStepNW.D == vector<vector<int>> {
             {3, 0, 1, 2},
             {8, 3, 2, 0},
@@ -239,18 +558,28 @@ SUITE(BalanceMatrix) {
         lastStepMin = m[3].solve(BalanceMatrix::Meth::Min).back();
         CHECK((lastStepNW.X == vector<vector<int>> {
             { 0, 30, 10, 10,  0},
-            {30,  0,  0,  0, -1},
+            {30,  0,  0,  0,  0},
             { 0,  0,  0, 10, 10}
         }));
+        CHECK((lastStepNW.eps == vector<vector<char>> {
+            {0, 0, 0, 0, 0},
+            {0, 0, 0, 0, 1},
+            {0, 0, 0, 0, 0}
+        }));
         CHECK((lastStepNW.D == vector<vector<int>> {
             {2, 0, 0, 0, 0},
             {0, 1, 2, 4, 0},
             {4, 0, 0, 0, 0}
         }));
         CHECK((lastStepMin.X == vector<vector<int>> {
-            {-1, 30,  0, 20,  0},
+            { 0, 30,  0, 20,  0},
             {30,  0,  0,  0,  0},
-            { 0, -2, 10,  0, 10}
+            { 0,  0, 10,  0, 10}
+        }));
+        CHECK((lastStepMin.eps == vector<vector<char>> {
+            {1, 0, 0, 0, 0},
+            {0, 0, 0, 0, 0},
+            {0, 1, 0, 0, 0}
         }));
         CHECK((lastStepMin.D == vector<vector<int>> {
             {0, 0, 0, 0, 0},
@@ -274,6 +603,385 @@ SUITE(BalanceMatrix) {
         }));
         CHECK(lastStepNW.X == lastStepMin.X);
     }
+    
+    TEST(StrikingOutCycle) {
+        // the cycle search used to stop striking out rows too early here
+        BalanceMatrix m;
+        CHECK(m.set({
+            {42, 99, 72, 93,  1, 21},
+            {30, 99, 15, 24, 10, 45},
+            {19, 39, 35, 67, 40, 94},
+            {54, 84, 42, 32, 68, 57},
+            {21, 44, 87, 23,  3, 58},
+            {55, 55, 55, 55, 55}
+        }));
+        
+        auto lastStepNW = m.solve(BalanceMatrix::Meth::NW).back();
+        auto lastStepMin = m.solve(BalanceMatrix::Meth::Min).back();
+        CHECK(lastStepNW.valid());
+        CHECK(lastStepNW.W == 6128);
+        CHECK(lastStepMin.valid());
+        CHECK(lastStepMin.W == 6128);
+    }
+    
+    TEST(DisconnectedBasis) {
+        // every allocation closes a row and a column, the plan falls apart
+        // into single cells that have to be joined by EPS links
+        BalanceMatrix m;
+        CHECK(m.set({
+            {4, 8, 1, 6, 10},
+            {7, 2, 9, 3, 10},
+            {5, 6, 3, 8, 10},
+            {2, 9, 7, 4, 10},
+            {10, 10, 10, 10}
+        }));
+        
+        auto lastStepNW = m.solve(BalanceMatrix::Meth::NW).back();
+        auto lastStepMin = m.solve(BalanceMatrix::Meth::Min).back();
+        CHECK(lastStepNW.valid());
+        CHECK(lastStepNW.W == 120);
+        CHECK(lastStepMin.valid());
+        CHECK(lastStepMin.W == 120);
+    }
+    
+    TEST_FIXTURE(MatricesFixture, CandidatePricing) {
+        for(unsigned candidatesNum : {0u, 1u, 3u}) {
+            BalanceMatrix::Options options;
+            options.pricing = BalanceMatrix::Pricing::candidates;
+            options.candidatesNum = candidatesNum;
+            
+            for(auto& matrix : m) {
+                for(auto meth : {BalanceMatrix::Meth::NW, BalanceMatrix::Meth::Min}) {
+                    auto lastStep = matrix.solve(meth, options).back();
+                    CHECK(lastStep.valid());
+                    CHECK(lastStep.W == matrix.solve(meth).back().W);
+                }
+            }
+        }
+    }
+    
+    TEST_FIXTURE(MatricesFixture, StepRecording) {
+        auto all = m[1].solve(BalanceMatrix::Meth::NW);
+        
+        BalanceMatrix::Options options;
+        options.record = BalanceMatrix::Record::last;
+        auto seen = 0u;
+        options.onStep = [&](BalanceMatrix::Step const& step) {
+            CHECK(step.X == all[seen].X);
+            ++seen;
+        };
+        auto last = m[1].solve(BalanceMatrix::Meth::NW, options);
+        CHECK(seen == all.size());
+        CHECK(last.size() == 1);
+        CHECK(last.back().X == all.back().X);
+        CHECK(last.back().W == all.back().W);
+        
+        options.onStep = nullptr;
+        options.record = BalanceMatrix::Record::every;
+        options.recordEvery = 2;
+        auto every = m[1].solve(BalanceMatrix::Meth::NW, options);
+        CHECK(every.size() == all.size() / 2 + 1);
+        CHECK(every.front().X == all.front().X);
+        CHECK(every.back().X == all.back().X);
+    }
+    
+    TEST_FIXTURE(MatricesFixture, NetworkMethod) {
+        auto positive = [](Matrix2D<int> x) {
+            for(auto i = 0u; i < x.rows(); ++i) {
+                for(auto& v : x[i]) v = std::max(v, 0);
+            }
+            return x;
+        };
+        
+        for(auto& matrix : m) {
+            auto steps = matrix.solve(BalanceMatrix::Meth::Network);
+            auto lastStepNW = matrix.solve(BalanceMatrix::Meth::NW).back();
+            CHECK(steps.size() == 1);
+            CHECK(steps.back().valid());
+            CHECK(steps.back().W == lastStepNW.W);
+        }
+        
+        // the plans that are the only optimal ones
+        for(int k : {0, 2, 4}) {
+            auto lastStep = m[k].solve(BalanceMatrix::Meth::Network).back();
+            CHECK(positive(lastStep.X) == positive(m[k].solve(BalanceMatrix::Meth::NW).back().X));
+        }
+    }
+    
+    TEST_FIXTURE(MatricesFixture, SolveTrace) {
+        Trace trace;
+        auto steps = m[1].solve(BalanceMatrix::Meth::NW, &trace);
+        CHECK(steps.back().X == m[1].solve(BalanceMatrix::Meth::NW).back().X);
+        
+        std::stringstream ss;
+        ss << trace;
+        auto json = ss.str();
+        CHECK(json.find("{\"traceEvents\":[") == 0);
+        CHECK(json.find("\"name\":\"flatten\"") != std::string::npos);
+        CHECK(json.find("\"name\":\"initial_plan\"") != std::string::npos);
+        CHECK(json.find("\"name\":\"advance_x\"") != std::string::npos);
+        
+        // an iteration per pivot, plus the one that finds the plan optimal
+        auto iterations = 0u;
+        for(auto pos = json.find("\"iteration\","); pos != std::string::npos; 
+            pos = json.find("\"iteration\",", pos + 1)) 
+        {
+            ++iterations;
+        }
+        CHECK(iterations == steps.size());
+    }
+    
+    TEST_FIXTURE(MatricesFixture, SparseArcs) {
+        using Arc = BalanceMatrix::Arc;
+        
+        // every cell as an arc gives what the dense matrix does
+        vector<Arc> arcs;
+        vector<vector<int>> costs {{5, 8, 4, 4}, {1, 2, 3, 8}, {4, 7, 6, 1}};
+        for(int i = 0; i < 3; ++i) {
+            for(int j = 0; j < 4; ++j) {
+                arcs.push_back({i, j, costs[i][j]});
+            }
+        }
+        BalanceMatrix sparse;
+        CHECK(sparse.set(arcs, {80, 45, 60}, {45, 60, 70, 40}));
+        
+        auto steps = sparse.solve_arcs();
+        CHECK(steps.size() == 1);
+        CHECK(steps.back().valid());
+        CHECK(steps.back().W == m[0].solve(BalanceMatrix::Meth::NW).back().W);
+        CHECK(sparse.solve(BalanceMatrix::Meth::NW).empty());
+        
+        // forbidden routes are what a huge cost used to stand for
+        BalanceMatrix huge;
+        CHECK(huge.set({
+            {   5,    8, 1000, 1000, 80},
+            {1000,    2,    3,    8, 45},
+            {   4, 1000,    6,    1, 60},
+            {45, 60, 70, 40}
+        }));
+        arcs = {{0, 0, 5}, {0, 1, 8}, {1, 1, 2}, {1, 2, 3}, {1, 3, 8}, {2, 0, 4}, {2, 2, 6}, {2, 3, 1}};
+        CHECK(sparse.set(arcs, {80, 45, 60}, {45, 60, 70, 40}));
+        
+        steps = sparse.solve_arcs();
+        CHECK(steps.size() == 1);
+        CHECK(steps.back().valid());
+        CHECK(steps.back().W == huge.solve(BalanceMatrix::Meth::Network).back().W);
+        
+        auto shipped = 0;
+        for(auto k = 0u; k < arcs.size(); ++k) {
+            CHECK(steps.back().X[k] >= 0);
+            shipped += steps.back().X[k];
+        }
+        CHECK(shipped == 185);
+        
+        // nothing reaches the last sink
+        CHECK(sparse.set({{0, 0, 1}, {1, 1, 1}}, {10, 10}, {10, 5, 5}));
+        CHECK(sparse.solve_arcs().empty());
+        
+        CHECK(!sparse.set({{0, 3, 1}}, {10}, {10}));
+    }
+    
+    TEST_FIXTURE(MatricesFixture, Capacities) {
+        // loose capacities change nothing
+        CHECK(m[0].set_capacities(Matrix2D<int>(3, 4, 100)));
+        for(auto meth : {BalanceMatrix::Meth::NW, BalanceMatrix::Meth::Min, BalanceMatrix::Meth::Vogel, BalanceMatrix::Meth::Network}) {
+            auto last = m[0].solve(meth).back();
+            CHECK(last.valid());
+            CHECK(last.W == 525);
+        }
+        
+        // tight ones push the plan off its cheapest cells
+        Matrix2D<int> caps (3, 4, 100);
+        caps[0][2] = 30;
+        caps[1][1] = 20;
+        caps[2][3] = 25;
+        CHECK(m[0].set_capacities(caps));
+        
+        BalanceMatrix::Options options;
+        for(auto pricing : {BalanceMatrix::Pricing::full, BalanceMatrix::Pricing::candidates}) {
+            options.pricing = pricing;
+            for(auto meth : {BalanceMatrix::Meth::NW, BalanceMatrix::Meth::Min, BalanceMatrix::Meth::Vogel, BalanceMatrix::Meth::Network}) {
+                auto steps = m[0].solve(meth, options);
+                CHECK(!steps.empty());
+                
+                auto const& last = steps.back();
+                CHECK(last.valid());
+                CHECK(last.W == 695);
+                CHECK(last.X[2][3] == 25);
+                CHECK(last.upper[2][3]);
+                for(auto i = 0u; i < caps.rows(); ++i) {
+                    for(auto j = 0u; j < caps.cols(); ++j) {
+                        CHECK(last.X[i][j] >= 0 && last.X[i][j] <= caps[i][j]);
+                    }
+                }
+            }
+        }
+        
+        // 40 cells of 10 can't carry 185
+        CHECK(m[0].set_capacities(Matrix2D<int>(3, 4, 10)));
+        CHECK(m[0].solve(BalanceMatrix::Meth::NW).empty());
+        
+        // and streams no steps it would take back
+        auto seen = 0;
+        options.onStep = [&seen](BalanceMatrix::Step const&) { ++seen; };
+        CHECK(m[0].solve(BalanceMatrix::Meth::Vogel, options).empty());
+        CHECK(seen == 0);
+        CHECK(m[0].solve(BalanceMatrix::Meth::Network).empty());
+        
+        CHECK(!m[0].set_capacities(Matrix2D<int>(2, 4, 10)));
+        CHECK(!m[0].set_capacities(Matrix2D<int>(3, 4, -1)));
+        CHECK(m[0].set_capacities({}));
+        CHECK(m[0].solve(BalanceMatrix::Meth::NW).back().upper.empty());
+        
+        // tenths that don't add up exactly, under loose and tight caps
+        using Tenths = BasicBalanceMatrix<double>;
+        Tenths tenths;
+        CHECK(tenths.set(Matrix2D<double>({{1, 2}, {3, 1}}), {0.1, 0.2}, {0.2, 0.1}));
+        Matrix2D<double> tenthCaps (2, 2, 1);
+        for(auto W : {0.5, 0.65}) {
+            CHECK(tenths.set_capacities(tenthCaps));
+            for(auto meth : {Tenths::Meth::NW, Tenths::Meth::Min, Tenths::Meth::Vogel, Tenths::Meth::Network}) {
+                auto steps = tenths.solve(meth);
+                CHECK(!steps.empty());
+                if(steps.empty()) continue;
+                CHECK(steps.back().valid());
+                CHECK_CLOSE(steps.back().W, W, 1e-9);
+            }
+            tenthCaps[0][0] = 0.05;
+        }
+    }
+    
+    TEST_FIXTURE(MatricesFixture, Assignment) {
+        BalanceMatrix a;
+        CHECK(a.set({
+            {9, 2, 7, 8, 1},
+            {6, 4, 3, 7, 1},
+            {5, 8, 1, 8, 1},
+            {7, 6, 9, 4, 1},
+            {1, 1, 1, 1}
+        }));
+        
+        auto steps = a.solve(BalanceMatrix::Meth::Assignment);
+        CHECK(steps.size() == 1);
+        
+        auto const& last = steps.back();
+        CHECK(last.valid());
+        CHECK(last.W == 13);
+        CHECK(last.W == a.solve(BalanceMatrix::Meth::Network).back().W);
+        
+        // a full basis, every assigned and eps cell priced at zero
+        int assigned = 0, eps = 0;
+        for(auto i = 0u; i < 4; ++i) {
+            for(auto j = 0u; j < 4; ++j) {
+                assigned += last.X[i][j];
+                eps += last.eps[i][j];
+                if(last.X[i][j] != 0 || last.eps[i][j]) CHECK(last.D[i][j] == 0);
+            }
+        }
+        CHECK(assigned == 4);
+        CHECK(eps == 3);
+        CHECK(last.X[0][1] == 1 && last.X[1][0] == 1 && last.X[2][2] == 1 && last.X[3][3] == 1);
+        
+        // only unit quantities on a square
+        CHECK(m[0].solve(BalanceMatrix::Meth::Assignment).empty());
+        CHECK(a.set_capacities(Matrix2D<int>(4, 4, 1)));
+        CHECK(a.solve(BalanceMatrix::Meth::Assignment).empty());
+    }
+    
+    TEST_FIXTURE(MatricesFixture, AuctionMethod) {
+        BalanceMatrix::Options options;
+        options.threadsNum = 2;
+        for(auto& matrix : m) {
+            auto steps = matrix.solve(BalanceMatrix::Meth::Auction, options);
+            CHECK(!steps.empty());
+            CHECK(steps.back().valid());
+            CHECK(steps.back().W == matrix.solve(BalanceMatrix::Meth::Network).back().W);
+            
+            // the first plan is optimal already
+            CHECK(steps.front().W == steps.back().W);
+        }
+        
+        BalanceMatrix zeroDemand;
+        CHECK(zeroDemand.set({
+            { 1, 2, 5},
+            { 3, 4, 5},
+            {10, 0}
+        }));
+        auto last = zeroDemand.solve(BalanceMatrix::Meth::Auction, options).back();
+        CHECK(last.valid());
+        CHECK(last.W == 20);
+        
+        // whole numbers only
+        BasicBalanceMatrix<double> fractional;
+        CHECK(fractional.set({
+            {1.5, 2, 10},
+            {  3, 1, 10},
+            { 10, 10}
+        }));
+        CHECK(fractional.solve(BasicBalanceMatrix<double>::Meth::Auction).empty());
+    }
+    
+    TEST(ValueTypes) {
+        // every method ends at the same least W
+        auto solvesTo = [&](auto const& matrix, auto W) {
+            using Matrix = typename std::decay<decltype(matrix)>::type;
+            for(auto meth : {Matrix::Meth::NW, Matrix::Meth::Min, Matrix::Meth::Vogel, Matrix::Meth::Network}) {
+                auto last = matrix.solve(meth).back();
+                CHECK(last.valid());
+                CHECK(last.W == W);
+            }
+        };
+        
+        // the fixture's first matrix with the costs by 1000 and the
+        // quantities by 100000, W is past what an int holds
+        BasicBalanceMatrix<long long> big;
+        CHECK(big.set({
+            {  5000,   8000,   4000,  4000, 8000000},
+            {  1000,   2000,   3000,  8000, 4500000},
+            {  4000,   7000,   6000,  1000, 6000000},
+            {4500000, 6000000, 7000000, 4000000}
+        }));
+        solvesTo(big, 52500000000LL);
+        
+        // negative costs no longer clash with the eps marks
+        BalanceMatrix shifted;
+        CHECK(shifted.set({
+            {-5, -2, -6, -6, 80},
+            {-9, -8, -7, -2, 45},
+            {-6, -3, -4, -9, 60},
+            {45, 60, 70, 40}
+        }));
+        solvesTo(shifted, 525 - 10 * 185);
+        
+        BasicBalanceMatrix<double> halves;
+        CHECK(halves.set({
+            {7, 8, 5, 3, 5.5},
+            {2, 4, 5, 9, 5.5},
+            {6, 3, 1, 2, 4},
+            {2.5, 4.5, 4.5, 3.5}
+        }));
+        solvesTo(halves, 44.5);
+        
+        // tenths don't add up exactly, the network simplex takes them
+        // as balanced all the same
+        BasicBalanceMatrix<double> tenths;
+        CHECK(tenths.set(Matrix2D<double>({{1, 2}, {3, 1}}), {0.1, 0.2}, {0.2, 0.1}));
+        for(auto meth : {tenths.Meth::NW, tenths.Meth::Min, tenths.Meth::Vogel, tenths.Meth::Network}) {
+            auto steps = tenths.solve(meth);
+            CHECK(!steps.empty());
+            if(steps.empty()) continue;
+            CHECK(steps.back().valid());
+            CHECK_CLOSE(steps.back().W, 0.5, 1e-9);
+        }
+        
+        BasicBalanceMatrix<Fraction> thirds;
+        CHECK(thirds.set(
+            Matrix2D<Fraction>(vector<vector<Fraction>> {{7, 8, 5, 3}, {2, 4, 5, 9}, {6, 3, 1, 2}}),
+            {Fraction(11, 3), Fraction(11, 3), Fraction(8, 3)},
+            {Fraction(5, 3), Fraction(9, 3), Fraction(9, 3), Fraction(7, 3)}
+        ));
+        solvesTo(thirds, Fraction(89, 3));
+    }
 }
 
 int main(int, char*[]) {